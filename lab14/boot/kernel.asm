@@ -45,6 +45,25 @@ global sysSetEdi
 global sysStartSysCall
 global sys_update_cr3
 global sys_interrupt_exit
+global sys_flush_tlb
+global sys_read_tsc
+global sys_invlpg ;使一个页的TLB项失效
+global sys_enable_global_pages ;设置cr4的PGE位
+global sys_enable_large_pages ;设置cr4的PSE位
+global sys_cpuid_features ;返回CPUID 1号功能的edx
+global sys_enable_simd ;允许使用MMX/SSE指令
+global sys_memcpy_movsd
+global sys_memset_stosd
+global sys_copy_page_movsd
+global sys_clear_page_stosd
+global sys_memcpy_mmx
+global sys_memset_mmx
+global sys_copy_page_mmx
+global sys_clear_page_mmx
+global sys_memcpy_sse2
+global sys_memset_sse2
+global sys_copy_page_sse2
+global sys_clear_page_sse2
 
 extern TimeInterruptResponse
 extern KeyboardInterruptResponse
@@ -54,6 +73,7 @@ extern PrintTime
 extern syscallTable
 extern copyProcess
 extern keyboardInterruptHandler
+extern pageFaultHandler
 
 _start:
     cli
@@ -66,6 +86,7 @@ _start:
     call init_keyboard_interrupt
     call init_time_interrupt
     call init_sys_call_interrupt
+    call init_page_fault_interrupt
 
     mov al, 0xf9 ; 键盘，IRQ2
     out 0x21, al
@@ -864,6 +885,453 @@ sys_update_cr3:
     pop eax
     ret
 
+sys_flush_tlb: ; 重新加载cr3，刷新TLB
+    push eax
+    mov eax, cr3
+    mov cr3, eax
+    pop eax
+    ret
+
+sys_read_tsc: ; 返回时间戳计数器的低32位
+    push edx
+    rdtsc
+    pop edx
+    ret
+
+sys_invlpg: ; 参数address，使address所在页的TLB项失效，全局页也会失效
+    push eax
+    mov eax, [esp+8]
+    invlpg [eax]
+    pop eax
+    ret
+
+sys_enable_global_pages: ; 设置cr4的PGE位，重新加载cr3时不再清除全局页的TLB项
+    push eax
+    mov eax, cr4
+    or eax, 0x80
+    mov cr4, eax
+    pop eax
+    ret
+
+sys_enable_large_pages: ; 设置cr4的PSE位，页目录项可以直接映射4MB的页
+    push eax
+    mov eax, cr4
+    or eax, 0x10
+    mov cr4, eax
+    pop eax
+    ret
+
+sys_cpuid_features: ; 返回CPUID 1号功能的edx，不支持CPUID时返回0
+    push ebx
+    ; 能够改变eflags的ID位说明支持CPUID
+    pushfd
+    pop eax
+    mov ecx, eax
+    xor eax, 0x200000
+    push eax
+    popfd
+    pushfd
+    pop eax
+    push ecx
+    popfd
+    xor eax, ecx
+    jz .unsupported
+
+    mov eax, 1
+    cpuid
+    mov eax, edx
+    pop ebx
+    ret
+.unsupported:
+    xor eax, eax
+    pop ebx
+    ret
+
+sys_enable_simd: ; 参数sse，允许使用MMX，sse不为0时同时允许使用SSE
+    push eax
+    mov eax, cr0
+    and eax, ~0x4 ; 清除EM位
+    or eax, 0x2   ; 设置MP位
+    mov cr0, eax
+    clts
+
+    cmp dword[esp+8], 0
+    je .done
+    mov eax, cr4
+    or eax, 0x600 ; 设置OSFXSR和OSXMMEXCPT位
+    mov cr4, eax
+.done:
+    pop eax
+    ret
+
+; 以下是内存操作的各种实现
+; 切换线程时不保存MMX和SSE寄存器，使用它们的实现在关中断的情况下进行
+
+sys_memcpy_movsd: ; 参数src，dst，count
+    push esi
+    push edi
+    mov esi, [esp+12]
+    mov edi, [esp+16]
+    mov edx, [esp+20]
+    cld
+    mov ecx, edx
+    shr ecx, 2
+    rep movsd
+    mov ecx, edx
+    and ecx, 3
+    rep movsb
+    pop edi
+    pop esi
+    ret
+
+sys_memset_stosd: ; 参数buffer，value(4个字节都是要填充的值)，count
+    push edi
+    mov edi, [esp+8]
+    mov eax, [esp+12]
+    mov edx, [esp+16]
+    cld
+    mov ecx, edx
+    shr ecx, 2
+    rep stosd
+    mov ecx, edx
+    and ecx, 3
+    rep stosb
+    pop edi
+    ret
+
+sys_copy_page_movsd: ; 参数src，dst，都按页对齐
+    push esi
+    push edi
+    mov esi, [esp+12]
+    mov edi, [esp+16]
+    mov ecx, 1024
+    cld
+    rep movsd
+    pop edi
+    pop esi
+    ret
+
+sys_clear_page_stosd: ; 参数buffer，按页对齐
+    push edi
+    mov edi, [esp+8]
+    xor eax, eax
+    mov ecx, 1024
+    cld
+    rep stosd
+    pop edi
+    ret
+
+sys_memcpy_mmx: ; 参数src，dst，count
+    push esi
+    push edi
+    pushfd
+    cli
+    mov esi, [esp+16]
+    mov edi, [esp+20]
+    mov edx, [esp+24]
+    mov ecx, edx
+    shr ecx, 6 ; 每次复制64字节
+    jz .tail
+.copy:
+    movq mm0, [esi]
+    movq mm1, [esi+8]
+    movq mm2, [esi+16]
+    movq mm3, [esi+24]
+    movq mm4, [esi+32]
+    movq mm5, [esi+40]
+    movq mm6, [esi+48]
+    movq mm7, [esi+56]
+    movq [edi], mm0
+    movq [edi+8], mm1
+    movq [edi+16], mm2
+    movq [edi+24], mm3
+    movq [edi+32], mm4
+    movq [edi+40], mm5
+    movq [edi+48], mm6
+    movq [edi+56], mm7
+    add esi, 64
+    add edi, 64
+    dec ecx
+    jnz .copy
+    emms
+.tail:
+    cld
+    mov ecx, edx
+    and ecx, 63
+    shr ecx, 2
+    rep movsd
+    mov ecx, edx
+    and ecx, 3
+    rep movsb
+    popfd
+    pop edi
+    pop esi
+    ret
+
+sys_memset_mmx: ; 参数buffer，value(4个字节都是要填充的值)，count
+    push edi
+    pushfd
+    cli
+    mov edi, [esp+12]
+    mov eax, [esp+16]
+    mov edx, [esp+20]
+    mov ecx, edx
+    shr ecx, 6
+    jz .tail
+    movd mm0, eax
+    punpckldq mm0, mm0
+.fill:
+    movq [edi], mm0
+    movq [edi+8], mm0
+    movq [edi+16], mm0
+    movq [edi+24], mm0
+    movq [edi+32], mm0
+    movq [edi+40], mm0
+    movq [edi+48], mm0
+    movq [edi+56], mm0
+    add edi, 64
+    dec ecx
+    jnz .fill
+    emms
+.tail:
+    cld
+    mov ecx, edx
+    and ecx, 63
+    shr ecx, 2
+    rep stosd
+    mov ecx, edx
+    and ecx, 3
+    rep stosb
+    popfd
+    pop edi
+    ret
+
+sys_copy_page_mmx: ; 参数src，dst，都按页对齐
+    push esi
+    push edi
+    pushfd
+    cli
+    mov esi, [esp+16]
+    mov edi, [esp+20]
+    mov ecx, 64
+.copy:
+    movq mm0, [esi]
+    movq mm1, [esi+8]
+    movq mm2, [esi+16]
+    movq mm3, [esi+24]
+    movq mm4, [esi+32]
+    movq mm5, [esi+40]
+    movq mm6, [esi+48]
+    movq mm7, [esi+56]
+    movq [edi], mm0
+    movq [edi+8], mm1
+    movq [edi+16], mm2
+    movq [edi+24], mm3
+    movq [edi+32], mm4
+    movq [edi+40], mm5
+    movq [edi+48], mm6
+    movq [edi+56], mm7
+    add esi, 64
+    add edi, 64
+    dec ecx
+    jnz .copy
+    emms
+    popfd
+    pop edi
+    pop esi
+    ret
+
+sys_clear_page_mmx: ; 参数buffer，按页对齐
+    push edi
+    pushfd
+    cli
+    mov edi, [esp+12]
+    mov ecx, 64
+    pxor mm0, mm0
+.fill:
+    movq [edi], mm0
+    movq [edi+8], mm0
+    movq [edi+16], mm0
+    movq [edi+24], mm0
+    movq [edi+32], mm0
+    movq [edi+40], mm0
+    movq [edi+48], mm0
+    movq [edi+56], mm0
+    add edi, 64
+    dec ecx
+    jnz .fill
+    emms
+    popfd
+    pop edi
+    ret
+
+sys_memcpy_sse2: ; 参数src，dst，count
+    push esi
+    push edi
+    pushfd
+    cli
+    mov esi, [esp+16]
+    mov edi, [esp+20]
+    mov edx, [esp+24]
+    mov ecx, edx
+    shr ecx, 6
+    jz .tail
+.copy:
+    movdqu xmm0, [esi]
+    movdqu xmm1, [esi+16]
+    movdqu xmm2, [esi+32]
+    movdqu xmm3, [esi+48]
+    movdqu [edi], xmm0
+    movdqu [edi+16], xmm1
+    movdqu [edi+32], xmm2
+    movdqu [edi+48], xmm3
+    add esi, 64
+    add edi, 64
+    dec ecx
+    jnz .copy
+.tail:
+    cld
+    mov ecx, edx
+    and ecx, 63
+    shr ecx, 2
+    rep movsd
+    mov ecx, edx
+    and ecx, 3
+    rep movsb
+    popfd
+    pop edi
+    pop esi
+    ret
+
+sys_memset_sse2: ; 参数buffer，value(4个字节都是要填充的值)，count
+    push edi
+    pushfd
+    cli
+    mov edi, [esp+12]
+    mov eax, [esp+16]
+    mov edx, [esp+20]
+    mov ecx, edx
+    shr ecx, 6
+    jz .tail
+    movd xmm0, eax
+    pshufd xmm0, xmm0, 0
+.fill:
+    movdqu [edi], xmm0
+    movdqu [edi+16], xmm0
+    movdqu [edi+32], xmm0
+    movdqu [edi+48], xmm0
+    add edi, 64
+    dec ecx
+    jnz .fill
+.tail:
+    cld
+    mov ecx, edx
+    and ecx, 63
+    shr ecx, 2
+    rep stosd
+    mov ecx, edx
+    and ecx, 3
+    rep stosb
+    popfd
+    pop edi
+    ret
+
+sys_copy_page_sse2: ; 参数src，dst，都按页对齐，写入时绕过cache
+    push esi
+    push edi
+    pushfd
+    cli
+    mov esi, [esp+16]
+    mov edi, [esp+20]
+    mov ecx, 64
+.copy:
+    movdqa xmm0, [esi]
+    movdqa xmm1, [esi+16]
+    movdqa xmm2, [esi+32]
+    movdqa xmm3, [esi+48]
+    movntdq [edi], xmm0
+    movntdq [edi+16], xmm1
+    movntdq [edi+32], xmm2
+    movntdq [edi+48], xmm3
+    add esi, 64
+    add edi, 64
+    dec ecx
+    jnz .copy
+    sfence
+    popfd
+    pop edi
+    pop esi
+    ret
+
+sys_clear_page_sse2: ; 参数buffer，按页对齐，写入时绕过cache
+    push edi
+    pushfd
+    cli
+    mov edi, [esp+12]
+    mov ecx, 64
+    pxor xmm0, xmm0
+.fill:
+    movntdq [edi], xmm0
+    movntdq [edi+16], xmm0
+    movntdq [edi+32], xmm0
+    movntdq [edi+48], xmm0
+    add edi, 64
+    dec ecx
+    jnz .fill
+    sfence
+    popfd
+    pop edi
+    ret
+
+init_page_fault_interrupt: ; 14号中断，页错误
+    pushad
+
+    mov eax, CODE_SELECTOR
+    shl eax, 16
+    mov ebx, page_fault_handler
+    and ebx, 0xffff
+    or eax, ebx
+    mov [IDT_START_ADDRESS+0x0e*8], eax
+
+    mov eax, page_fault_handler
+    and eax, 0xffff0000
+    or eax, 0x00008e00
+    mov [IDT_START_ADDRESS+0x0e*8+4], eax
+
+    ; 设置cr0的WP位，内核写只读的用户页时也会引发页错误，写时复制才能生效
+    mov eax, cr0
+    or eax, 0x10000
+    mov cr0, eax
+
+    popad
+    ret
+
+page_fault_handler: ; CPU已压入错误码
+    pushad
+    push ds
+    push es
+    push gs
+
+    mov eax, DATA_SELECTOR
+    mov ds, eax
+    mov es, eax
+    mov eax, VIDEO_SELECTOR
+    mov gs, eax
+
+    push dword[esp+14*4] ; 发生页错误时的eflags
+    push dword[esp+12*4] ; 错误码
+    mov eax, cr2         ; 引起页错误的地址
+    push eax
+    call pageFaultHandler
+    add esp, 12
+
+    pop gs
+    pop es
+    pop ds
+    popad
+    add esp, 4 ; 越过错误码
+    iret
+
 init_sys_call_interrupt: ; 0x80中断
     pushad
     
@@ -1,6 +1,8 @@
 %include "boot.inc"
 section LOADER vstart=LOADER_START_ADDRESS   
     ;ds=0
+    call detect_memory
+
     ;双字 dd dword 32位
     ;0#号空描述符
     mov dword [GDT_START_ADDRESS+0x00],0x00
@@ -84,6 +86,33 @@ protect_mode_begin:
 pgdt dw 0
      dd GDT_START_ADDRESS
 
+[bits 16]
+detect_memory:
+;使用BIOS的int 15h E820功能获取内存布局，保存到MEMORY_MAP_ADDRESS处
+;每项20字节：基地址(8字节)，长度(8字节)，类型(4字节)，BIOS不支持时内存块数为0
+   xor eax, eax
+   mov es, ax
+   mov dword [MEMORY_MAP_ADDRESS], 0
+   mov di, MEMORY_MAP_ADDRESS + 4
+   xor ebx, ebx                      ;第一次调用时ebx为0
+.e820_next:
+   mov eax, 0xe820
+   mov ecx, 20
+   mov edx, 0x534d4150               ;'SMAP'
+   int 0x15
+   jc .e820_done                     ;出错或已经没有更多的内存块
+   cmp eax, 0x534d4150
+   jne .e820_done
+   add di, 20
+   inc dword [MEMORY_MAP_ADDRESS]
+   cmp dword [MEMORY_MAP_ADDRESS], MEMORY_MAP_MAX_ENTRIES
+   jae .e820_done
+   test ebx, ebx                     ;ebx为0表示这是最后一个内存块
+   jnz .e820_next
+.e820_done:
+   ret
+[bits 32]
+
 setup_page:
 ;先把页目录占用的空间逐字节清0
    mov ecx, 4096
@@ -3,11 +3,67 @@
 
 #include "../kernel/oslib.h"
 
+// CPUID 1号功能edx中的功能位
+#define CPUID_PSE (1 << 3)
+#define CPUID_PGE (1 << 13)
+#define CPUID_MMX (1 << 23)
+#define CPUID_SSE (1 << 25)
+#define CPUID_SSE2 (1 << 26)
+
+extern "C" dword sys_cpuid_features();
+extern "C" void sys_enable_simd(dword sse);
+extern "C" void sys_memcpy_movsd(const void *src, void *dst, dword count);
+extern "C" void sys_memset_stosd(void *buffer, dword value, dword count);
+extern "C" void sys_copy_page_movsd(const void *src, void *dst);
+extern "C" void sys_clear_page_stosd(void *buffer);
+extern "C" void sys_memcpy_mmx(const void *src, void *dst, dword count);
+extern "C" void sys_memset_mmx(void *buffer, dword value, dword count);
+extern "C" void sys_copy_page_mmx(const void *src, void *dst);
+extern "C" void sys_clear_page_mmx(void *buffer);
+extern "C" void sys_memcpy_sse2(const void *src, void *dst, dword count);
+extern "C" void sys_memset_sse2(void *buffer, dword value, dword count);
+extern "C" void sys_copy_page_sse2(const void *src, void *dst);
+extern "C" void sys_clear_page_sse2(void *buffer);
+
+// 一组内存操作的实现
+struct MemoryOperations
+{
+    const char *name;                                       // 实现的名字
+    dword features;                                         // 需要的CPUID功能位
+    void (*copy)(const void *src, void *dst, dword count);  // 复制count个字节
+    void (*set)(void *buffer, dword value, dword count);    // 填充count个字节，value的4个字节相同
+    void (*copyPage)(const void *src, void *dst);           // 复制一个按页对齐的页
+    void (*clearPage)(void *buffer);                        // 清零一个按页对齐的页
+};
+
+#define MEMORY_OPERATION_VARIANTS 3
+
+// 按速度从慢到快排列，rep movsd/stosd在所有CPU上可用
+const MemoryOperations memoryOperationVariants[MEMORY_OPERATION_VARIANTS] = {
+    {"movsd", 0, sys_memcpy_movsd, sys_memset_stosd, sys_copy_page_movsd, sys_clear_page_stosd},
+    {"mmx", CPUID_MMX, sys_memcpy_mmx, sys_memset_mmx, sys_copy_page_mmx, sys_clear_page_mmx},
+    {"sse2", CPUID_SSE | CPUID_SSE2, sys_memcpy_sse2, sys_memset_sse2, sys_copy_page_sse2, sys_clear_page_sse2},
+};
+
+// 当前使用的实现，常量初始化，调用initMemoryOperations之前也可以使用。
+// 只有copyPage和clearPage使用它，copy和set留给基准测试比较
+const MemoryOperations *memoryOperations = memoryOperationVariants;
+// CPUID 1号功能的edx
+dword cpuFeatures;
+
 // 加载用户程序
 void _start_program(dword num);
+// 根据CPUID选择可用的最快的内存操作实现，需要在内核态调用
+void initMemoryOperations();
+// 判断CPU是否支持实现operations
+bool isMemoryOperationsSupported(const MemoryOperations *operations);
 void memset(byte *buffer, byte value, dword length);
 void memcpy(byte *src, byte *dst, dword count);
 void memcpy(void *src, void *dst, dword count);
+// 复制一个页，src和dst都按页对齐，并且都已映射
+void copyPage(const void *src, void *dst);
+// 清零一个页，buffer按页对齐，并且已映射
+void clearPage(void *buffer);
 void _start_program(dword num)
 {
     /*byte buffer[512];
@@ -25,31 +81,57 @@ void _start_program(dword num)
     */
 }
 
-void memset(byte *buffer, byte value, dword length)
+void initMemoryOperations()
 {
-    for (int i = 0; i < length; ++i)
+    cpuFeatures = sys_cpuid_features();
+
+    if (cpuFeatures & CPUID_MMX)
+    {
+        sys_enable_simd(cpuFeatures & CPUID_SSE);
+    }
+
+    for (int i = MEMORY_OPERATION_VARIANTS - 1; i >= 0; --i)
     {
-        buffer[i] = value;
+        if (isMemoryOperationsSupported(memoryOperationVariants + i))
+        {
+            memoryOperations = memoryOperationVariants + i;
+            break;
+        }
     }
 }
 
+bool isMemoryOperationsSupported(const MemoryOperations *operations)
+{
+    return (cpuFeatures & operations->features) == operations->features;
+}
+
+// memset和memcpy可能访问没有映射的用户页，页错误处理中还会复制和清零页，
+// 使用MMX/SSE寄存器会被页错误处理破坏，只用rep movsd/stosd
+void memset(byte *buffer, byte value, dword length)
+{
+    sys_memset_stosd(buffer, value * 0x01010101u, length);
+}
+
 void memcpy(byte *src, byte *dst, dword count)
 {
-    for (int i = 0; i < count; ++i)
-    {
-        dst[i] = src[i];
-    }
+    sys_memcpy_movsd(src, dst, count);
 }
 
 void memcpy(void *src, void *dst, dword count)
 {
-    byte *srcPtr = (byte *)src;
-    byte *dstPtr = (byte *)dst;
+    sys_memcpy_movsd(src, dst, count);
+}
+
+// 只复制和清零已映射的页，不会发生页错误，可以使用最快的实现
+
+void copyPage(const void *src, void *dst)
+{
+    memoryOperations->copyPage(src, dst);
+}
 
-    for (int i = 0; i < count; ++i)
-    {
-        dstPtr[i] = srcPtr[i];
-    }
+void clearPage(void *buffer)
+{
+    memoryOperations->clearPage(buffer);
 }
 
 #endif
\ No newline at end of file
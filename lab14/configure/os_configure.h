@@ -12,8 +12,13 @@
 #define PARTITIONS_AMOUNT 2
 // 第1个分区起始扇区
 #define PARTITION_0_START 0
-// 第2个分区起始扇区
-#define PARTITION_1_START 151
+// 第2个分区起始扇区，位于内核区(KERNEL_START_SECTOR起的KERNEL_SECTOR_COUNT个扇区)之后。
+// 由151改为251后文件系统在硬盘上的位置变了，旧的hd.img中的文件系统会被内核区覆盖，需要重新生成硬盘镜像
+#define PARTITION_1_START 251
+// 交换区占用的扇区数，交换区位于硬盘末尾
+#define SWAP_SECTOR_AMOUNT 4096
+// 交换区起始扇区
+#define SWAP_START (HADR_DISK_SECTOR_AMOUNT - SWAP_SECTOR_AMOUNT)
 /******************************************************************/
 
 /******************************************************************/
@@ -1,96 +1,209 @@
 #include "bitmap.h"
 
+#define BITS_PER_WORD 32
+#define FULL_WORD 0xffffffff
+
 BitMap::BitMap()
 {
     bitmap = nullptr;
     length = 0;
+    freeCount = 0;
+    hint = 0;
 }
 
 void BitMap::setBitMap(byte *bitmap, const dword length)
 {
     this->bitmap = bitmap;
     this->length = length;
+    this->freeCount = length;
+    this->hint = 0;
 
-    dword len = length / 8;
-    if (length % 8)
-        ++len;
+    dword *words = (dword *)bitmap;
+    dword amount = storageSize(length) / sizeof(dword);
 
-    for (int i = 0; i < len; ++i)
+    for (int i = 0; i < amount; ++i)
     {
-        bitmap[i] = 0;
+        words[i] = 0;
+    }
+
+    // 最后一个字中超出length的位视为已分配，搜索时无需再判断越界
+    if (length % BITS_PER_WORD)
+    {
+        words[amount - 1] = FULL_WORD << (length % BITS_PER_WORD);
     }
 }
 
 bool BitMap::get(const dword index)
 {
-    dword pos = index / 8;
-    dword offset = (7 - (index % 8));
-    byte mask = 1 << offset;
+    dword *words = (dword *)bitmap;
+    dword mask = 1u << (index % BITS_PER_WORD);
 
-    return (bitmap[pos] & mask);
+    return (words[index / BITS_PER_WORD] & mask);
 }
 
 void BitMap::set(const dword index, const bool status)
 {
-    dword pos = index / 8;
-    dword offset = (7 - (index % 8));
-    byte mask = 0xfe;
-    for (int i = 0; i < offset; ++i)
+    dword *words = (dword *)bitmap;
+    dword mask = 1u << (index % BITS_PER_WORD);
+    dword *target = words + index / BITS_PER_WORD;
+
+    if (((*target & mask) != 0) == status)
+        return;
+
+    if (status)
     {
-        mask = (mask << 1) + 1;
+        *target = *target | mask;
+        --freeCount;
+    }
+    else
+    {
+        *target = *target & (~mask);
+        ++freeCount;
     }
-    bitmap[pos] = bitmap[pos] & mask;
-
-    mask = status << offset;
-    bitmap[pos] = bitmap[pos] | mask;
 }
 
 dword BitMap::allocate(const dword count)
 {
-    if (count == 0)
+    if (count == 0 || count > freeCount)
         return -1;
 
-    dword index = 0, empty, start;
+    // 先从上次分配结束的位置向后找，找不到再从头找到hint处
+    dword start = findRun(hint, length, count);
+    if (start == -1 && hint)
+    {
+        dword end = hint + count - 1;
+        start = findRun(0, end < length ? end : length, count);
+    }
+
+    if (start == -1)
+        return -1;
+
+    fill(start, count, true);
+    freeCount -= count;
+
+    hint = start + count;
+    if (hint >= length)
+        hint = 0;
+
+    return start;
+}
 
-    while (index < length)
+void BitMap::release(const dword index, const dword count)
+{
+    fill(index, count, false);
+    freeCount += count;
+}
+
+dword BitMap::largestFreeRun()
+{
+    dword largest = 0, start, end;
+
+    for (dword from = 0; from < length; from = end)
     {
-        while (index < length && get(index))
-            ++index;
+        start = findFree(from, length);
+        end = findUsed(start, length);
+        if (end - start > largest)
+        {
+            largest = end - start;
+        }
+    }
 
-        if (index == length)
-            return -1;
+    return largest;
+}
+
+void *BitMap::getBitmapData() {
+    return bitmap;
+}
 
-        empty = 0;
-        start = index;
-        while ((index < length) && (!get(index)) && (empty < count))
+dword BitMap::storageSize(const dword length)
+{
+    return (length + BITS_PER_WORD - 1) / BITS_PER_WORD * sizeof(dword);
+}
+
+dword BitMap::findFree(dword from, const dword to)
+{
+    dword *words = (dword *)bitmap;
+    dword value;
+
+    while (from < to)
+    {
+        // 只看from及其之后的位，已满的字整字跳过
+        value = ~words[from / BITS_PER_WORD] & (FULL_WORD << (from % BITS_PER_WORD));
+        if (value)
         {
-            ++empty;
-            ++index;
+            from = from - from % BITS_PER_WORD + __builtin_ctz(value);
+            return from < to ? from : to;
         }
+        from = from - from % BITS_PER_WORD + BITS_PER_WORD;
+    }
+
+    return to;
+}
 
-        if (empty == count)
+dword BitMap::findUsed(dword from, const dword to)
+{
+    dword *words = (dword *)bitmap;
+    dword value;
+
+    while (from < to)
+    {
+        // 全空的字整字跳过
+        value = words[from / BITS_PER_WORD] & (FULL_WORD << (from % BITS_PER_WORD));
+        if (value)
         {
-            for (int i = 0; i < count; ++i)
-            {
-                set(start + i, true);
-            }
+            from = from - from % BITS_PER_WORD + __builtin_ctz(value);
+            return from < to ? from : to;
         }
-        return start;
+        from = from - from % BITS_PER_WORD + BITS_PER_WORD;
     }
 
-    return -1;
+    return to;
 }
 
-void BitMap::release(const dword index, const dword count)
+dword BitMap::findRun(dword from, const dword to, const dword count)
 {
-    
-    for (int i = 0; i < count; ++i)
+    dword start, end;
+
+    while (from < to)
     {
-        //printf("%d %d\n", index + i, length);
-        set(index + i, false);
+        start = findFree(from, to);
+        if (to - start < count)
+            return -1;
+
+        // 只需检查start之后的count位
+        end = findUsed(start, start + count);
+        if (end == start + count)
+            return start;
+
+        from = end + 1;
     }
+
+    return -1;
 }
 
-void *BitMap::getBitmapData() {
-    return bitmap;
-}
\ No newline at end of file
+void BitMap::fill(dword index, dword count, const bool status)
+{
+    dword *words = (dword *)bitmap;
+    dword offset, bits, mask;
+
+    while (count)
+    {
+        offset = index % BITS_PER_WORD;
+        bits = BITS_PER_WORD - offset;
+        if (bits > count)
+            bits = count;
+
+        mask = (bits == BITS_PER_WORD) ? FULL_WORD : (((1u << bits) - 1) << offset);
+        if (status)
+        {
+            words[index / BITS_PER_WORD] |= mask;
+        }
+        else
+        {
+            words[index / BITS_PER_WORD] &= ~mask;
+        }
+
+        index += bits;
+        count -= bits;
+    }
+}
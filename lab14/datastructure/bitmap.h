@@ -3,6 +3,8 @@
 
 #include "../configure/type.h"
 
+// BitMap按32位字存储，第index位位于第index / 32个字的第index % 32位，
+// 因此存储空间需要按字对齐，其大小由storageSize给出
 class BitMap
 {
 public:
@@ -10,6 +12,10 @@ public:
     dword length;
     // bitmap的起始地址
     byte *bitmap;
+    // 空闲资源的个数
+    dword freeCount;
+    // 下一次分配开始搜索的位置(next-fit)
+    dword hint;
 public:
     // 初始化
     BitMap();
@@ -23,8 +29,22 @@ public:
     dword allocate(const dword count);
     // 释放第index个资源开始的count个资源
     void release(const dword index, const dword count);
+    // 最长的连续空闲资源个数
+    dword largestFreeRun();
     // 返回数据源
     void *getBitmapData();
+    // 管理length个资源所需的字节数，按字对齐
+    static dword storageSize(const dword length);
+
+private:
+    // 在[from, to)中找到第一个空闲位，若没有则返回to
+    dword findFree(dword from, const dword to);
+    // 在[from, to)中找到第一个已分配位，若没有则返回to
+    dword findUsed(dword from, const dword to);
+    // 在[from, to)中找到count个连续的空闲位，若没有则返回-1
+    dword findRun(dword from, const dword to, const dword count);
+    // 将第index个资源开始的count个资源设置为status
+    void fill(dword index, dword count, const bool status);
 };
 
-#endif
\ No newline at end of file
+#endif
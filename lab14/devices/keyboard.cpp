@@ -21,6 +21,7 @@ void Keyboard::initialize()
     head = end = 0;
 
     mutex.initialize(1);
+    keys.initialize(0);
 
     SHIFT_ON = false;
     CAPS_ON = false;
@@ -95,6 +96,7 @@ bool Keyboard::push(byte code)
 
     buffer[end] = code;
     end = (end + 1) % KEYBOARD_BUFFER_SIZE;
+    keys.V();
     return true;
 }
 
@@ -114,6 +116,19 @@ bool Keyboard::pop(byte *code)
     return true;
 }
 
+byte Keyboard::read()
+{
+    byte code;
+
+    // pop也会取走扫描码，被唤醒时缓冲区可能已空
+    do
+    {
+        keys.P();
+    } while (!pop(&code));
+
+    return code;
+}
+
 byte Keyboard::scanCode2Char(byte c)
 {
     if (c & 0x80)
@@ -26,6 +26,7 @@ private:
     byte keymap[KEY_MAP_NUM][2];
     dword head, end;
     Semaphore mutex;
+    Semaphore keys; // 缓冲区中的扫描码个数，没有输入时读者在此阻塞
 
     bool SHIFT_ON;
     bool CAPS_ON;
@@ -35,6 +36,8 @@ public:
     void initialize();
     bool push(byte code);
     bool pop(byte *code);
+    // 读取一个扫描码，没有输入时阻塞等待
+    byte read();
     byte scanCode2Char(byte c);
 };
 
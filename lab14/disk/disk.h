@@ -5,6 +5,10 @@
 #include "../configure/os_configure.h"
 #include "../kernel/oslib.h"
 #include "../clib/cstdio.h"
+#include "../memory/slab.h"
+
+// 等待磁盘就绪时最多查询状态端口的次数
+#define DISK_POLL_LIMIT 0x400000
 
 // 实现硬盘按块存取，按字节存取
 
@@ -14,62 +18,34 @@ private:
     Disk();
 
 public:
-    // 按块写入，每次写一个块
-    static void write(dword start, void *buf)
+    // 按块写入，每次写一个块，出错或超时返回false
+    static bool write(dword start, void *buf)
     {
-        byte *buffer = (byte *)buf;
-
-        waitForDisk(start, SECTOR_SIZE, 0x30);
+        // 一个块的命令和数据传输之间不能插入其他线程的命令，块之间可以被调度
+        bool status = _interrupt_status();
+        _disable_interrupt();
+        bool ans = writeSector(start, (byte *)buf);
+        _set_interrupt(status);
 
-        for (int i = 0; i < SECTOR_SIZE; i += 2)
-        {
-            dword temp = (buffer[i + 1] << 8) + buffer[i];
-            // intel下需要按小端方式写，因为读的时候是按小端方式读取的
-            outw_port(0x1f0, temp); // 每次需要向ox1f0写入一个字
-
-            temp = _in_port(0x1f7);
-            if (temp & 0x1)
-            {
-                temp = _in_port(0x1f1);
-                printf("---Disk::write---\n"
-                       "Disk Error: 0x%x\n",
-                       temp);
-                return;
-            }
-        }
+        return ans;
     }
 
-    // 按块读出
-    static void read(dword start, void *buf)
+    // 按块读出，出错或超时返回false
+    static bool read(dword start, void *buf)
     {
-        byte *buffer = (byte *)buf;
-
-        waitForDisk(start, SECTOR_SIZE, 0x20);
-
-        for (int i = 0; i < SECTOR_SIZE; i += 2)
-        {
-            dword temp = inw_port(0x1f0); // 0x1f0需要读入一个字，否则会发生错误
-            buffer[i] = temp & 0xff;
-            temp = temp >> 8;
-            buffer[i + 1] = temp & 0xff;
+        bool status = _interrupt_status();
+        _disable_interrupt();
+        bool ans = readSector(start, (byte *)buf);
+        _set_interrupt(status);
 
-            temp = _in_port(0x1f7);
-            if (temp & 0x1)
-            {
-                temp = _in_port(0x1f1);
-                printf("---Disk::read---\n"
-                       "Disk Error: 0x%x\n",
-                       temp);
-                return;
-            }
-        }
+        return ans;
     }
 
     // 按字节写入
     static void writeBytes(dword startByte, void *buf, dword size)
     {
         byte *buffer = (byte *)buf;
-        byte *temp = (byte *)kernelMalloc(SECTOR_SIZE);
+        byte *temp = (byte *)sectorCache.allocate();
         if (!temp)
         {
             printf("---Disk::writeBytes---\n"
@@ -114,14 +90,14 @@ public:
             write(endSector, temp);
         }
 
-        kernelFree(temp);
+        sectorCache.release(temp);
     }
 
     // 按字节读出
     static void readBytes(dword startByte, void *buf, dword size)
     {
         byte *buffer = (byte *)buf;
-        byte *temp = (byte *)kernelMalloc(SECTOR_SIZE);
+        byte *temp = (byte *)sectorCache.allocate();
         if (!temp)
         {
             printf("---Disk::readBytes---\n"
@@ -165,11 +141,77 @@ public:
             }
         }
 
-        kernelFree(temp);
+        sectorCache.release(temp);
     }
 
 private:
-    static void waitForDisk(dword start, dword amount, dword type)
+    // 写入一个块，调用时中断是关闭的
+    static bool writeSector(dword start, byte *buffer)
+    {
+        if (!waitForDisk(start, SECTOR_SIZE, 0x30))
+            return false;
+
+        for (int i = 0; i < SECTOR_SIZE; i += 2)
+        {
+            dword temp = (buffer[i + 1] << 8) + buffer[i];
+            // intel下需要按小端方式写，因为读的时候是按小端方式读取的
+            outw_port(0x1f0, temp); // 每次需要向ox1f0写入一个字
+
+            temp = _in_port(0x1f7);
+            if (temp & 0x1)
+            {
+                temp = _in_port(0x1f1);
+                printf("---Disk::write---\n"
+                       "Disk Error: 0x%x\n",
+                       temp);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // 读出一个块，调用时中断是关闭的
+    static bool readSector(dword start, byte *buffer)
+    {
+        if (!waitForDisk(start, SECTOR_SIZE, 0x20))
+            return false;
+
+        for (int i = 0; i < SECTOR_SIZE; i += 2)
+        {
+            dword temp = inw_port(0x1f0); // 0x1f0需要读入一个字，否则会发生错误
+            buffer[i] = temp & 0xff;
+            temp = temp >> 8;
+            buffer[i + 1] = temp & 0xff;
+
+            temp = _in_port(0x1f7);
+            if (temp & 0x1)
+            {
+                temp = _in_port(0x1f1);
+                printf("---Disk::read---\n"
+                       "Disk Error: 0x%x\n",
+                       temp);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // 软件复位控制器，丢弃超时命令未完成的数据传输
+    static void reset()
+    {
+        _out_port(0x3f6, 0x04);
+        _out_port(0x3f6, 0x00);
+
+        // 等待控制器退出忙状态
+        for (dword i = 0; i < DISK_POLL_LIMIT && (_in_port(0x1f7) & 0x80); ++i)
+        {
+        }
+    }
+
+    // 发出读写命令并等待磁盘就绪，出错或超时返回false
+    static bool waitForDisk(dword start, dword amount, dword type)
     {
         dword temp;
 
@@ -184,7 +226,7 @@ private:
         _out_port(0x1f6, (temp & 0xf) | 0xe0);
         _out_port(0x1f7, type);
 
-        while (1)
+        for (dword i = 0; i < DISK_POLL_LIMIT; ++i)
         {
             temp = _in_port(0x1f7);
             if (temp & 0x1)
@@ -193,16 +235,21 @@ private:
                 printf("---Disk::wairForDisk---\n"
                        "Disk Error: 0x%x\n",
                        temp);
-                return;
+                return false;
             }
             else
             {
                 if ((temp & 0x88) == 0x8)
                 {
-                    return;
+                    return true;
                 }
             }
         }
+
+        reset();
+        printf("---Disk::wairForDisk---\n"
+               "Disk Timeout\n");
+        return false;
     }
 };
 
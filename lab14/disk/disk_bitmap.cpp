@@ -42,7 +42,7 @@ void DiskBitMap::setBitMap(const dword start, const dword length)
 
 dword DiskBitMap::allocate()
 {
-    byte *buffer = (byte *)kernelMalloc(SECTOR_SIZE);
+    byte *buffer = (byte *)sectorCache.allocate();
     if (!buffer)
     {
         return -1;
@@ -76,14 +76,14 @@ dword DiskBitMap::allocate()
                     // 同步化到磁盘
                     
                     Disk::write(i + start, buffer);
-                    kernelFree(buffer);
+                    sectorCache.release(buffer);
                     return k + counter;
                 }
             }
         }
     }
 
-    kernelFree(buffer);
+    sectorCache.release(buffer);
     return -1;
 }
 
@@ -96,7 +96,7 @@ void DiskBitMap::release(const dword index)
     dword offset = (index % BITS_PER_SECTOR) / 8;
     dword bit = index % BITS_PER_SECTOR % 8;
 
-    byte *buffer = (byte *)kernelMalloc(SECTOR_SIZE);
+    byte *buffer = (byte *)sectorCache.allocate();
     if (!buffer)
     {
         return;
@@ -106,4 +106,5 @@ void DiskBitMap::release(const dword index)
     buffer[offset] = buffer[offset] & (~masks[bit]);
 
     Disk::write(start + sector, buffer);
+    sectorCache.release(buffer);
 }
\ No newline at end of file
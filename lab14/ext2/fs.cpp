@@ -31,8 +31,8 @@ void FileSystem::init()
     {
         // 致敬 1924.11.12
         sb.magic = 0x19241112;
-        // 文件系统所能管理的扇区数，0分区用于内核代码，1分区是文件系统管理区
-        sb.totalSectors = HADR_DISK_SECTOR_AMOUNT - PARTITION_1_START + 1;
+        // 文件系统所能管理的扇区数，0分区用于内核代码，1分区是文件系统管理区，硬盘末尾是交换区
+        sb.totalSectors = SWAP_START - PARTITION_1_START + 1;
         // 越过超级块
         sb.inodeBitmapStartSector = 1 + PARTITION_1_START;
         sb.inodeBitmapLength = stdmath::roundup(MAX_FILES, BITS_PER_SECTOR);
@@ -108,7 +108,7 @@ void FileSystem::init()
 
     DirectoryEntry dir;
 
-    byte *buffer = (byte *)kernelMalloc(SECTOR_SIZE);
+    byte *buffer = (byte *)sectorCache.allocate();
     for (int i = 0; i < SECTOR_SIZE; ++i)
     {
         buffer[i] = 0xff;
@@ -127,6 +127,7 @@ void FileSystem::init()
 
     // 首地址必须是字节
     Disk::write(sb.dataFieldStartSector, buffer);
+    sectorCache.release(buffer);
 
     Inode root;
     root.blocks[0] = sb.dataFieldStartSector;
@@ -392,6 +393,59 @@ dword FileSystem::writeFileBlock(dword handle, dword block, void *buf)
     return true;
 }
 
+bool FileSystem::isMappable(dword handle, bool writable)
+{
+    if (handle >= MAX_SYSTEM_OPENED_FILES ||
+        !openedFiles[handle].count ||
+        openedFiles[handle].type != REGULAR_FILE ||
+        !(openedFiles[handle].mode & READ))
+        return false;
+
+    return !writable || (openedFiles[handle].mode & WRITE);
+}
+
+bool FileSystem::readPage(dword handle, dword offset, void *page)
+{
+    if (handle >= MAX_SYSTEM_OPENED_FILES || !(openedFiles[handle].mode & READ))
+        return false;
+
+    Inode &inode = openedFiles[handle].inode;
+    byte *buffer = (byte *)page;
+
+    // 直接读入page，不经过扇区缓冲区
+    for (dword i = 0; i < PAGE_SIZE / SECTOR_SIZE; ++i)
+    {
+        dword block = offset / SECTOR_SIZE + i;
+        if (block >= inode.blockAmount)
+            break;
+
+        inode.readBlock(block, buffer + i * SECTOR_SIZE);
+    }
+
+    return true;
+}
+
+bool FileSystem::writePage(dword handle, dword offset, void *page)
+{
+    if (handle >= MAX_SYSTEM_OPENED_FILES || !(openedFiles[handle].mode & WRITE))
+        return false;
+
+    Inode &inode = openedFiles[handle].inode;
+    byte *buffer = (byte *)page;
+
+    // 映射不改变文件大小，超出文件末尾的修改被丢弃
+    for (dword i = 0; i < PAGE_SIZE / SECTOR_SIZE; ++i)
+    {
+        dword block = offset / SECTOR_SIZE + i;
+        if (block >= inode.blockAmount)
+            break;
+
+        inode.writeBlock(block, buffer + i * SECTOR_SIZE);
+    }
+
+    return true;
+}
+
 dword FileSystem::appendFileBlock(dword handle)
 {
     dword block = allocateDataBlock();
@@ -728,16 +782,17 @@ dword FileSystem::allocateDataBlock()
     if (sector == -1)
         return -1;
 
-    byte *buffer = (byte *)kernelMalloc(SECTOR_SIZE);
+    byte *buffer = (byte *)sectorCache.allocate();
     if (!buffer)
     {
-        PANIC::halt(PANIC_MEMORY_EXHAUSTED, "FileSystem::allocateDataBlock", "kernelMalloc");
+        PANIC::halt(PANIC_MEMORY_EXHAUSTED, "FileSystem::allocateDataBlock", "sectorCache");
     }
     for (int i = 0; i < SECTOR_SIZE; ++i)
     {
         buffer[i] = 0xff;
     }
     Disk::write(sector + sb.dataFieldStartSector, buffer);
+    sectorCache.release(buffer);
     // printf("allocate datablock: %d\n", sector);
     return sector + sb.dataFieldStartSector;
 }
@@ -65,6 +65,15 @@ public:
     // 按路径删除文件
     dword deleteFile(const char *path, dword type);
 
+    // 文件能否以writable方式映射到用户空间，只有普通文件可以映射
+    bool isMappable(dword handle, bool writable);
+
+    // 从文件偏移offset开始读取一页到page中，文件末尾之后的部分不修改
+    bool readPage(dword handle, dword offset, void *page);
+
+    // 将page写回文件偏移offset开始的一页，只写入文件已有的数据块
+    bool writePage(dword handle, dword offset, void *page);
+
 public:
     // 找到路径path对应的inode
     Inode pathToInode(const char *path, dword type); // pass
@@ -60,10 +60,10 @@ struct Inode
         dword endBlock = (startByte + size - 1) / SECTOR_SIZE;
         dword first, len, totalBytes;
 
-        byte *temp = (byte *)kernelMalloc(SECTOR_SIZE);
+        byte *temp = (byte *)sectorCache.allocate();
         if (!temp)
         {
-            PANIC::halt(PANIC_MEMORY_EXHAUSTED, "Inode::read", "kernelMalloc");
+            PANIC::halt(PANIC_MEMORY_EXHAUSTED, "Inode::read", "sectorCache");
         }
 
         // 处理头部区块
@@ -103,7 +103,7 @@ struct Inode
             }
         }
 
-        kernelFree(temp);
+        sectorCache.release(temp);
         return true;
     }
 
@@ -118,17 +118,17 @@ struct Inode
         else if (index - INODE_BLOCK_DIRECT < INODE_BLOCK_FIRST)
         {
             // 处理一级数据块
-            dword *temp = (dword *)kernelMalloc(SECTOR_SIZE);
+            dword *temp = (dword *)sectorCache.allocate();
             if (!temp)
             {
-                PANIC::halt(PANIC_MEMORY_EXHAUSTED, "Inode::readBlock", "kernelMalloc");
+                PANIC::halt(PANIC_MEMORY_EXHAUSTED, "Inode::readBlock", "sectorCache");
             }
             
             Disk::read(blocks[INODE_BLOCK_DIRECT + 0], temp);
             dword offset = index - INODE_BLOCK_DIRECT;
             
             Disk::read(temp[offset], buf);
-            kernelFree(temp);
+            sectorCache.release(temp);
         }
         else
         {
@@ -144,7 +144,7 @@ struct Inode
     // 读取字节流，隐藏离散的扇区的信息
     void write(dword startByte, void *buf, dword size)
     {
-        byte *temp = (byte *)kernelMalloc(SECTOR_SIZE);
+        byte *temp = (byte *)sectorCache.allocate();
         if (!temp)
         {
             PANIC::halt(PANIC_MEMORY_EXHAUSTED, "Inode::write");
@@ -196,7 +196,7 @@ struct Inode
             writeBlock(endBlock, temp);
         }
 
-        kernelFree(temp);
+        sectorCache.release(temp);
     }
 
     // buf的大小一定是SECTOR_SIZE
@@ -211,7 +211,7 @@ struct Inode
         else if (index < INODE_BLOCK_FIRST)
         {
             // 处理一级数据块
-            dword *temp = (dword *)kernelMalloc(SECTOR_SIZE);
+            dword *temp = (dword *)sectorCache.allocate();
             if (!temp)
             {
                 PANIC::halt(PANIC_MEMORY_EXHAUSTED, "Inode::write");
@@ -220,7 +220,7 @@ struct Inode
             dword offset = index - INODE_BLOCK_DIRECT;
             //printf("%d %d %d\n", blocks[INODE_BLOCK_DIRECT + 0], offset, temp[offset]);
             Disk::write(temp[offset], buf);
-            kernelFree(temp);
+            sectorCache.release(temp);
         }
         else
         {
@@ -238,7 +238,7 @@ struct Inode
         else if (blockAmount - INODE_BLOCK_DIRECT < INODE_BLOCK_FIRST)
         {
             dword offset = blockAmount - INODE_BLOCK_DIRECT;
-            dword *temp = (dword *)kernelMalloc(SECTOR_SIZE);
+            dword *temp = (dword *)sectorCache.allocate();
             if (!temp)
             {
                 PANIC::halt(PANIC_MEMORY_EXHAUSTED);
@@ -247,7 +247,7 @@ struct Inode
             temp[offset] = block;
             //printf("%d %d %d\n", blocks[INODE_BLOCK_DIRECT + 0], offset, temp[offset]);
             Disk::write(blocks[INODE_BLOCK_DIRECT + 0], temp);
-            kernelFree(temp);
+            sectorCache.release(temp);
         }
 
         ++blockAmount;
@@ -267,13 +267,14 @@ struct Inode
         else if (blockAmount - INODE_BLOCK_DIRECT < INODE_BLOCK_FIRST)
         {
             dword offset = blockAmount - INODE_BLOCK_DIRECT;
-            dword *temp = (dword *)kernelMalloc(SECTOR_SIZE);
+            dword *temp = (dword *)sectorCache.allocate();
             if (!temp)
             {
                 PANIC::halt(PANIC_MEMORY_EXHAUSTED, "FileSystem::blockPopBack");
             }
             Disk::read(blocks[INODE_BLOCK_DIRECT + 0], temp);
             lastBlock = temp[offset];
+            sectorCache.release(temp);
         }
 
         --blockAmount;
@@ -43,8 +43,8 @@ void Kernel()
 
 void init()
 {
-    // 32MB内存，bochs内置
-    initMemoryPool(0x2000000);
+    // 根据loader获取的内存布局初始化地址池
+    initMemoryPool();
     _all_threads.initialize();
     _ready_threads.initialize();
     PID = 0;
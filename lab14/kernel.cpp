@@ -8,14 +8,22 @@
 #include "program/lock.h"
 
 #include "memory/memory.cpp"
+#include "memory/buddy.cpp"
+#include "memory/zero_pool.cpp"
+#include "memory/slab.cpp"
+#include "memory/shm.cpp"
+#include "memory/swap.cpp"
+#include "memory/stats.cpp"
 #include "program/memory_manager.cpp"
 #include "program/thread.cpp"
 #include "program/process.cpp"
 #include "program/program_manager.cpp"
 #include "program/threadlist.cpp"
 #include "program/addresspool.cpp"
+#include "program/vma.cpp"
 #include "program/sync.cpp"
 #include "kernel/syscall.cpp"
+#include "kernel/timer.cpp"
 #include "shell/shell.cpp"
 #include "ext2/fs.cpp"
 #include "disk/disk_bitmap.cpp"
@@ -32,23 +40,40 @@ void Kernel()
     init();
 
     dword pid = sysProgramManager.executeThread(firstThread, nullptr, "first thread", 2);
-    ThreadListItem *item = sysProgramManager.readyPrograms.front();
-    PCB *thread = (PCB *)(((dword)item) & 0xfffff000);
+    PCB *thread = sysProgramManager.popReady();
     thread->status = ThreadStatus::RUNNING;
     sysProgramManager.currentRunning = thread;
-    sysProgramManager.readyPrograms.pop_front();
 
     _switch_thread_to((void *)0x9f000, thread);
 }
 
 void init()
 {
-    // 32MB内存，bochs内置
-    initMemoryPool(0x2000000);
+    // 根据CPUID选择内存操作的实现
+    initMemoryOperations();
+
+    // 内核页设为全局页
+    enableGlobalPages();
+
+    // 直接映射区使用4MB的页
+    enableLargePages();
+
+    // 根据loader获取的内存布局初始化地址池
+    initMemoryPool();
+
+    // 初始化预清零页池
+    initZeroPagePools();
+
+    // 初始化内核对象缓存
+    initSlabCaches();
+    initSharedSegments();
 
     // 初始化系统调用表
     sysInitializeSysCall();
 
+    // 初始化定时器
+    initTimers();
+
     // 初始化程序管理器
     sysProgramManager.initialize();
 
@@ -60,6 +85,7 @@ void init()
 
     // 初始化文件系统
     sysFileSystem.init();
+    initSwap();
 
     // 初始化键盘驱动
     sysKeyboard.initialize();
@@ -86,7 +112,11 @@ void firstProcess(void *arg)
 void firstThread(void *arg)
 {
     _enable_interrupt();
+    // 优先级最低的清零线程
+    sysProgramManager.executeThread(zeroPageThread, nullptr, "page zeroing", 1);
     sysProgramManager.executeProcess((void *)firstProcess, "", 1);
+    // 之后只是空转，降到最低优先级，否则优先级更高的本线程会一直占用处理器
+    sysProgramManager.setPriority(sysProgramManager.running(), MIN_PRIORITY);
     while (1)
     {
     }
@@ -9,6 +9,7 @@
 #include "../devices/keyboard.h"
 #include "../clib/cstdio.h"
 #include "syscall.h"
+#include "timer.h"
 
 extern "C" void KeyboardInterruptResponse(dword param);
 extern "C" void TimeInterruptResponse();
@@ -100,9 +101,12 @@ void TimeInterruptResponse()
     
     ///printf("ticks: %d\n", cur->ticks);
 
-    if (!cur->ticks)
+    // 先唤醒到期的睡眠线程，它们可能抢占当前线程
+    runTimers();
+
+    // 时间片用完或有更高优先级的线程就绪时切换
+    if (sysProgramManager.tick())
     {
-       // printf("YES\n");
         userScheduleThread();
     }
     --cur->ticks;
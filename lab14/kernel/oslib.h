@@ -20,7 +20,13 @@ extern "C" void _call_interrupt(dword num, dword eax, dword ebx, dword ecx, dwor
 extern "C" void PrintTime();
 extern "C" dword inw_port(dword port);
 extern "C" void outw_port(dword port, dword content);
+extern "C" dword sys_read_tsc();
+extern "C" void _enable_interrupt();
+extern "C" void _disable_interrupt();
+extern "C" bool _interrupt_status();
 
+// 恢复中断状态，status为_interrupt_status的返回值
+void _set_interrupt(bool status);
 // 打印字符到显示屏，颜色字符预先指定
 void PutChar(dword c);
 // 从键盘缓冲区读入字符
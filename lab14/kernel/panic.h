@@ -5,6 +5,8 @@
 #include "../clib/cstdio.h"
 
 #define PANIC_MEMORY_EXHAUSTED 0
+#define PANIC_PAGE_FAULT 1
+#define PANIC_KMAP_EXHAUSTED 2
 
 class PANIC
 {
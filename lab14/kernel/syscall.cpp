@@ -26,6 +26,21 @@ void sysInitializeSysCall()
     syscallTable[SYSCALL_FILE_CLOSE] = (void *)sysFileClose;
     syscallTable[SYSCALL_FILE_WRITE] = (void *)sysFileWrite;
     syscallTable[SYSCALL_FILE_READ] = (void *)sysFileRead;
+    syscallTable[SYSCALL_REALLOC] = (void *)sysRealloc;
+    syscallTable[SYSCALL_CALLOC] = (void *)sysCalloc;
+    syscallTable[SYSCALL_MMAP] = (void *)sysMmap;
+    syscallTable[SYSCALL_MUNMAP] = (void *)sysMunmap;
+    syscallTable[SYSCALL_MSYNC] = (void *)sysMsync;
+    syscallTable[SYSCALL_SHMGET] = (void *)sysShmget;
+    syscallTable[SYSCALL_SHMAT] = (void *)sysShmat;
+    syscallTable[SYSCALL_SHMDT] = (void *)sysShmdt;
+    syscallTable[SYSCALL_MEMORY_STATS] = (void *)sysMemoryStats;
+    syscallTable[SYSCALL_SET_PRIORITY] = (void *)sysSetPriority;
+    syscallTable[SYSCALL_NICE] = (void *)sysNice;
+    syscallTable[SYSCALL_SCHEDULE_INFO] = (void *)sysScheduleInfo;
+    syscallTable[SYSCALL_SCHEDULE_POLICY] = (void *)sysSchedulePolicy;
+    syscallTable[SYSCALL_SLEEP] = (void *)sysSleep;
+    syscallTable[SYSCALL_SHMRM] = (void *)sysShmrm;
 }
 
 void *syscall(dword function, dword ebx, dword ecx,
@@ -156,46 +171,209 @@ void free(void *address)
     syscall(SYSCALL_FREE, (dword)address);
 }
 
-void *sysKernelMalloc()
+void *sysRealloc(void *address, dword size)
 {
-    dword size = (dword)sysGetEbx();
+    PCB *pcb = sysProgramManager.running();
+    if (pcb->pageDir)
+    {
+        return pcb->memoryManager.reallocate(address, size);
+    }
+    else
+    {
+        return sysMemoryManager.reallocate(address, size);
+    }
+}
 
-    bool status = _interrupt_status();
-    _disable_interrupt();
+void *realloc(void *address, dword size)
+{
+    return syscall(SYSCALL_REALLOC, (dword)address, size);
+}
+
+void *sysCalloc(dword amount, dword size)
+{
+    // 乘积溢出
+    if (size && amount > 0xffffffff / size)
+        return nullptr;
 
     PCB *pcb = sysProgramManager.running();
-    dword *temp = pcb->pageDir;
-    pcb->pageDir = nullptr;
+    if (pcb->pageDir)
+    {
+        return pcb->memoryManager.allocateZeroed(amount * size);
+    }
+    else
+    {
+        return sysMemoryManager.allocateZeroed(amount * size);
+    }
+}
 
-    void *ans = sysMemoryManager.allocate(size);
+void *calloc(dword amount, dword size)
+{
+    return syscall(SYSCALL_CALLOC, amount, size);
+}
 
-    pcb->pageDir = temp;
+void *sysMmap(dword handle, dword offset, dword size, dword flags)
+{
+    return mapFile(handle, offset, size, flags);
+}
 
-    _set_interrupt(status);
-    return ans;
+void *mmap(dword handle, dword offset, dword size, dword flags)
+{
+    return syscall(SYSCALL_MMAP, handle, offset, size, flags);
 }
 
-void *kernelMalloc(dword size)
+dword sysMunmap(void *address, dword size)
 {
-    void *ans = syscall(SYSCALL_KERNEL_MALLOC, size);
-    return ans;
+    return unmapFile((dword)address, size);
 }
 
-void sysKernelFree()
+bool munmap(void *address, dword size)
 {
-    void *address = (void *)sysGetEbx();
+    return (dword)syscall(SYSCALL_MUNMAP, (dword)address, size);
+}
+
+dword sysMsync(void *address, dword size)
+{
+    return syncFile((dword)address, size);
+}
+
+bool msync(void *address, dword size)
+{
+    return (dword)syscall(SYSCALL_MSYNC, (dword)address, size);
+}
+
+dword sysShmget(dword key, dword size)
+{
+    return getSharedSegment(key, size);
+}
+
+dword shmget(dword key, dword size)
+{
+    return (dword)syscall(SYSCALL_SHMGET, key, size);
+}
+
+void *sysShmat(dword id)
+{
+    return attachSharedSegment(id);
+}
+
+void *shmat(dword id)
+{
+    return syscall(SYSCALL_SHMAT, id);
+}
+
+dword sysShmdt(void *address)
+{
+    return detachSharedSegment((dword)address);
+}
+
+bool shmdt(void *address)
+{
+    return (dword)syscall(SYSCALL_SHMDT, (dword)address);
+}
 
+dword sysShmrm(dword id)
+{
+    return removeSharedSegment(id);
+}
+
+bool shmrm(dword id)
+{
+    return (dword)syscall(SYSCALL_SHMRM, id);
+}
+
+void sysMemoryStats(MemoryStats *stats)
+{
+    getMemoryStats(stats);
+}
+
+void memoryStats(MemoryStats *stats)
+{
+    syscall(SYSCALL_MEMORY_STATS, (dword)stats);
+}
+
+dword sysSetPriority(dword pid, dword priority)
+{
+    // 查找和修改之间线程不能退出
     bool status = _interrupt_status();
     _disable_interrupt();
 
-    PCB *pcb = sysProgramManager.running();
-    dword *temp = pcb->pageDir;
-    pcb->pageDir = nullptr;
-
-    sysMemoryManager.release(address);
+    PCB *program = sysProgramManager.findProgramByPid(pid);
+    if (program)
+    {
+        sysProgramManager.setPriority(program, priority > MAX_PRIORITY ? MAX_PRIORITY : priority);
+    }
 
-    pcb->pageDir = temp;
     _set_interrupt(status);
+    return program != nullptr;
+}
+
+bool setpriority(dword pid, dword priority)
+{
+    return (dword)syscall(SYSCALL_SET_PRIORITY, pid, priority);
+}
+
+dword sysNice(int increment)
+{
+    // 和Unix一样，increment越大优先级越低，返回新的优先级
+    PCB *program = sysProgramManager.running();
+    sysProgramManager.setPriority(program, (int)program->priority - increment);
+    return program->priority;
+}
+
+dword nice(int increment)
+{
+    return (dword)syscall(SYSCALL_NICE, increment);
+}
+
+dword sysScheduleInfo(ScheduleInfo *info, dword amount)
+{
+    return sysProgramManager.scheduleInfo(info, amount);
+}
+
+dword scheduleInfo(ScheduleInfo *info, dword amount)
+{
+    return (dword)syscall(SYSCALL_SCHEDULE_INFO, (dword)info, amount);
+}
+
+dword sysSchedulePolicy(dword policy)
+{
+    if (policy != SchedulePolicy::ROUND_ROBIN && policy != SchedulePolicy::MLFQ)
+        return false;
+
+    sysProgramManager.setSchedulePolicy((SchedulePolicy)policy);
+    return true;
+}
+
+bool schedulePolicy(dword policy)
+{
+    return (dword)syscall(SYSCALL_SCHEDULE_POLICY, policy);
+}
+
+void sysSleep(dword ms)
+{
+    // 按时钟中断计时，不足一次的部分向上取整
+    sysProgramManager.sleep(msToTicks(ms));
+}
+
+void sleep(dword ms)
+{
+    syscall(SYSCALL_SLEEP, ms);
+}
+
+void *sysKernelMalloc()
+{
+    return kmalloc((dword)sysGetEbx());
+}
+
+void *kernelMalloc(dword size)
+{
+    void *ans = syscall(SYSCALL_KERNEL_MALLOC, size);
+    return ans;
+}
+
+void sysKernelFree()
+{
+    kfree((void *)sysGetEbx());
 }
 
 void kernelFree(void *address)
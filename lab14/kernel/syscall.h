@@ -3,6 +3,9 @@
 
 #include "type.h"
 
+struct MemoryStats;
+struct ScheduleInfo;
+
 // 如果要获取eax寄存器的内容，geteax需要首先被调用
 extern "C" dword sysGetEax();
 extern "C" dword sysGetEbx();
@@ -18,7 +21,7 @@ extern "C" void sysSetEsi(dword value);
 extern "C" void sysSetEdi(dword value);
 extern "C" void *sysStartSysCall();
 
-#define SYSCALL_AMOUNT 30
+#define SYSCALL_AMOUNT 33
 void *syscallTable[SYSCALL_AMOUNT]; // 系统调用函数表
 
 #define SYSCALL_FIRST_SYS_CALL 0
@@ -39,6 +42,21 @@ void *syscallTable[SYSCALL_AMOUNT]; // 系统调用函数表
 #define SYSCALL_FILE_CLOSE 15
 #define SYSCALL_FILE_READ 16
 #define SYSCALL_FILE_WRITE 17
+#define SYSCALL_REALLOC 18
+#define SYSCALL_CALLOC 19
+#define SYSCALL_MMAP 20
+#define SYSCALL_MUNMAP 21
+#define SYSCALL_MSYNC 22
+#define SYSCALL_SHMGET 23
+#define SYSCALL_SHMAT 24
+#define SYSCALL_SHMDT 25
+#define SYSCALL_MEMORY_STATS 26
+#define SYSCALL_SET_PRIORITY 27
+#define SYSCALL_NICE 28
+#define SYSCALL_SCHEDULE_INFO 29
+#define SYSCALL_SCHEDULE_POLICY 30
+#define SYSCALL_SLEEP 31
+#define SYSCALL_SHMRM 32
 
 // 初始化系统调用表
 void sysInitializeSysCall();
@@ -70,6 +88,21 @@ dword sysFileOpen(const char *path, dword mode, dword type); // 14号系统调
 void sysFileClose(dword handle);                             // 15号系统调用，关闭文件
 void sysFileRead(dword handle, dword index, void *buffer);   // 16号系统调用，读取文件
 void sysFileWrite(dword handle, dword index, void *buffer);  // 17号系统调用，写入文件
+void *sysRealloc(void *address, dword size);                 // 18号系统调用，调整内存大小
+void *sysCalloc(dword amount, dword size);                   // 19号系统调用，分配清零的内存
+void *sysMmap(dword handle, dword offset, dword size, dword flags); // 20号系统调用，映射文件
+dword sysMunmap(void *address, dword size);                  // 21号系统调用，解除文件映射
+dword sysMsync(void *address, dword size);                   // 22号系统调用，写回文件映射的脏页
+dword sysShmget(dword key, dword size);                      // 23号系统调用，创建或查找共享内存段
+void *sysShmat(dword id);                                    // 24号系统调用，连接共享内存段
+dword sysShmdt(void *address);                               // 25号系统调用，断开共享内存段
+void sysMemoryStats(MemoryStats *stats);                     // 26号系统调用，内存统计信息
+dword sysSetPriority(dword pid, dword priority);             // 27号系统调用，设置线程/进程的优先级
+dword sysNice(int increment);                                // 28号系统调用，降低当前线程/进程的优先级
+dword sysScheduleInfo(ScheduleInfo *info, dword amount);     // 29号系统调用，各线程的调度信息
+dword sysSchedulePolicy(dword policy);                       // 30号系统调用，切换调度策略
+void sysSleep(dword ms);                                     // 31号系统调用，睡眠ms毫秒
+dword sysShmrm(dword id);                                    // 32号系统调用，移除共享内存段
 
 /***************************************************************/
 
@@ -79,6 +112,8 @@ void write(const char *ptr);
 void userScheduleThread();
 void *malloc(dword size);
 void free(void *address);
+void *realloc(void *address, dword size);
+void *calloc(dword amount, dword size);
 void *kernelMalloc(dword size);
 void kernelFree(void *address);
 dword fork();
@@ -93,6 +128,19 @@ dword open(const char *path, dword mode, dword type);
 void close(dword handle);
 void read(dword handle, dword index, void *buffer);
 void write(dword handle, dword index, void *buffer);
+void *mmap(dword handle, dword offset, dword size, dword flags);
+bool munmap(void *address, dword size);
+bool msync(void *address, dword size);
+dword shmget(dword key, dword size);
+void *shmat(dword id);
+bool shmdt(void *address);
+bool shmrm(dword id);
+void memoryStats(MemoryStats *stats);
+bool setpriority(dword pid, dword priority);
+dword nice(int increment);
+dword scheduleInfo(ScheduleInfo *info, dword amount);
+bool schedulePolicy(dword policy);
+void sleep(dword ms);
 
 /***************************************************************/
 #endif
\ No newline at end of file
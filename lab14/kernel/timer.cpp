@@ -0,0 +1,104 @@
+#include "timer.h"
+#include "interrupt.h"
+
+// 从所在的槽中删除定时器
+static void unlinkTimer(Timer *timer)
+{
+    if (timer->previous)
+    {
+        timer->previous->next = timer->next;
+    }
+    else
+    {
+        *(timer->slot) = timer->next;
+    }
+
+    if (timer->next)
+    {
+        timer->next->previous = timer->previous;
+    }
+
+    timer->slot = nullptr;
+}
+
+void initTimers()
+{
+    // 全局变量不调用构造函数
+    timerTicks = 0;
+    for (int i = 0; i < TIMER_WHEEL_SIZE; ++i)
+    {
+        timerWheel[i] = nullptr;
+    }
+}
+
+void addTimer(Timer *timer, dword ticks, TimerCallback callback, void *arg)
+{
+    if (!ticks)
+    {
+        ticks = 1;
+    }
+
+    bool status = _interrupt_status();
+    _disable_interrupt();
+
+    timer->expires = timerTicks + ticks;
+    timer->callback = callback;
+    timer->arg = arg;
+
+    timer->slot = timerWheel + (timer->expires & (TIMER_WHEEL_SIZE - 1));
+    timer->previous = nullptr;
+    timer->next = *(timer->slot);
+    if (timer->next)
+    {
+        timer->next->previous = timer;
+    }
+    *(timer->slot) = timer;
+
+    _set_interrupt(status);
+}
+
+bool cancelTimer(Timer *timer)
+{
+    bool status = _interrupt_status();
+    _disable_interrupt();
+
+    bool pending = timer->slot != nullptr;
+    if (pending)
+    {
+        unlinkTimer(timer);
+    }
+
+    _set_interrupt(status);
+    return pending;
+}
+
+void runTimers()
+{
+    Timer *timer, *next, *expired = nullptr;
+
+    ++timerTicks;
+
+    // 槽中还有几圈之后才到期的定时器，比较到期计数挑出本次到期的
+    for (timer = timerWheel[timerTicks & (TIMER_WHEEL_SIZE - 1)]; timer; timer = next)
+    {
+        next = timer->next;
+        if (timer->expires == timerTicks)
+        {
+            unlinkTimer(timer);
+            timer->next = expired;
+            expired = timer;
+        }
+    }
+
+    // 全部摘下后再回调，回调中可以注册或取消定时器
+    for (timer = expired; timer; timer = next)
+    {
+        next = timer->next;
+        timer->callback(timer->arg);
+    }
+}
+
+dword msToTicks(dword ms)
+{
+    return ms / MS_PER_TICK + (ms % MS_PER_TICK != 0);
+}
@@ -0,0 +1,41 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include "../configure/type.h"
+
+// 没有设置8253，时钟中断使用默认的约18.2Hz，每次约55毫秒
+#define MS_PER_TICK 55
+// 时间轮的槽数，必须是2的幂
+#define TIMER_WHEEL_SIZE 64
+
+typedef void (*TimerCallback)(void *arg);
+
+// 定时器，到期时在时钟中断中调用callback(arg)，回调中不能阻塞
+struct Timer
+{
+    Timer **slot;           // 所在的时间轮槽，不在时间轮中时为nullptr
+    Timer *previous, *next; // 在槽中的位置
+    dword expires;          // 到期时的时钟中断计数
+    TimerCallback callback;
+    void *arg;
+};
+
+// 开机以来的时钟中断计数
+dword timerTicks;
+
+// 哈希时间轮，到期计数模TIMER_WHEEL_SIZE相同的定时器放在同一个槽中，
+// 注册和取消是O(1)的，每次时钟中断只检查一个槽
+Timer *timerWheel[TIMER_WHEEL_SIZE];
+
+// 初始化时间轮
+void initTimers();
+// 注册定时器，ticks次时钟中断后到期，ticks为0时按1计算
+void addTimer(Timer *timer, dword ticks, TimerCallback callback, void *arg);
+// 取消注册过的定时器，返回定时器是否还未到期
+bool cancelTimer(Timer *timer);
+// 每次时钟中断时调用，执行本次到期的定时器
+void runTimers();
+// 毫秒数换算成时钟中断数，向上取整
+dword msToTicks(dword ms);
+
+#endif
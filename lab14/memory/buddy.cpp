@@ -0,0 +1,202 @@
+#include "buddy.h"
+#include "../kernel/interrupt.h"
+
+BuddyPool::BuddyPool()
+{
+    startAddress = 0;
+    length = 0;
+    freeCount = 0;
+}
+
+void BuddyPool::initialize(const dword startAddress, const dword length)
+{
+    this->startAddress = startAddress;
+    this->length = length;
+    this->freeCount = 0;
+    this->usableCount = 0;
+
+    for (int i = 0; i <= BUDDY_MAX_ORDER; ++i)
+    {
+        freeLists[i] = BUDDY_NULL;
+    }
+
+    for (dword i = 0; i < length; ++i)
+    {
+        frame(i)->flags = 0;
+        frame(i)->refCount = 0;
+    }
+}
+
+dword BuddyPool::largestFree()
+{
+    for (int order = BUDDY_MAX_ORDER; order >= 0; --order)
+    {
+        if (freeLists[order] != BUDDY_NULL)
+            return 1u << order;
+    }
+
+    return 0;
+}
+
+dword BuddyPool::allocate(const dword count)
+{
+    if (count == 0 || count > freeCount)
+        return -1;
+
+    // 找到能容纳count个页的最小的阶
+    dword order = 0;
+    while (order <= BUDDY_MAX_ORDER && (1u << order) < count)
+        ++order;
+
+    if (order > BUDDY_MAX_ORDER)
+        return -1;
+
+    bool status = _interrupt_status();
+    _disable_interrupt();
+
+    dword index = allocateBlock(order);
+    if (index == (dword)-1)
+    {
+        _set_interrupt(status);
+        return -1;
+    }
+
+    // 多出的尾部页框立即归还
+    releaseRange(index + count, (1u << order) - count);
+    freeCount -= count;
+
+    for (dword i = 0; i < count; ++i)
+    {
+        frame(index + i)->refCount = 1;
+        frame(index + i)->age = 0;
+    }
+
+    _set_interrupt(status);
+
+    return startAddress + index * PAGE_SIZE;
+}
+
+void BuddyPool::release(const dword address, const dword amount)
+{
+    bool status = _interrupt_status();
+    _disable_interrupt();
+
+    releaseRange((address - startAddress) / PAGE_SIZE, amount);
+    freeCount += amount;
+
+    _set_interrupt(status);
+}
+
+bool BuddyPool::contains(const dword address)
+{
+    return address >= startAddress && address < startAddress + length * PAGE_SIZE;
+}
+
+dword BuddyPool::allocateBlock(const dword order)
+{
+    dword current = order;
+    while (current <= BUDDY_MAX_ORDER && freeLists[current] == BUDDY_NULL)
+        ++current;
+
+    if (current > BUDDY_MAX_ORDER)
+        return -1;
+
+    dword index = freeLists[current];
+    removeFree(index, current);
+
+    // 逐级拆分，后一半放回低一阶的空闲链表
+    while (current > order)
+    {
+        --current;
+        pushFree(index + (1u << current), current);
+    }
+
+    return index;
+}
+
+void BuddyPool::releaseBlock(dword index, dword order)
+{
+    dword buddy;
+    PageFrame *buddyFrame;
+
+    while (order < BUDDY_MAX_ORDER)
+    {
+        buddy = index ^ (1u << order);
+        if (buddy + (1u << order) > length)
+            break;
+
+        buddyFrame = frame(buddy);
+        if (!(buddyFrame->flags & PAGE_FRAME_FREE) || buddyFrame->order != order)
+            break;
+
+        removeFree(buddy, order);
+        if (buddy < index)
+            index = buddy;
+        ++order;
+    }
+
+    pushFree(index, order);
+}
+
+void BuddyPool::releaseRange(dword index, const dword amount)
+{
+    dword end = index + amount;
+    dword order;
+
+    while (index < end)
+    {
+        // 以index为起点、不超过end的最大对齐块
+        order = 0;
+        while (order < BUDDY_MAX_ORDER &&
+               !(index & (1u << order)) &&
+               index + (2u << order) <= end)
+        {
+            ++order;
+        }
+
+        releaseBlock(index, order);
+        index += 1u << order;
+    }
+}
+
+void BuddyPool::pushFree(const dword index, const dword order)
+{
+    PageFrame *item = frame(index);
+    item->flags |= PAGE_FRAME_FREE;
+    item->order = order;
+    item->previous = BUDDY_NULL;
+    item->next = freeLists[order];
+
+    if (freeLists[order] != BUDDY_NULL)
+    {
+        frame(freeLists[order])->previous = index;
+    }
+    freeLists[order] = index;
+}
+
+void BuddyPool::removeFree(const dword index, const dword order)
+{
+    PageFrame *item = frame(index);
+
+    if (item->previous == BUDDY_NULL)
+    {
+        freeLists[order] = item->next;
+    }
+    else
+    {
+        frame(item->previous)->next = item->next;
+    }
+
+    if (item->next != BUDDY_NULL)
+    {
+        frame(item->next)->previous = item->previous;
+    }
+
+    item->flags &= ~PAGE_FRAME_FREE;
+    item->next = item->previous = BUDDY_NULL;
+}
+
+PageFrame *BuddyPool::frame(const dword index)
+{
+    return pageFrames + startAddress / PAGE_SIZE + index;
+}
@@ -0,0 +1,68 @@
+#ifndef BUDDY_H
+#define BUDDY_H
+
+#include "../configure/type.h"
+#include "../configure/os_configure.h"
+
+// 最大的阶，最大的块为2^BUDDY_MAX_ORDER个页，即4MB
+#define BUDDY_MAX_ORDER 10
+// 空闲链表的空指针
+#define BUDDY_NULL 0xffffffff
+
+// 页框状态
+#define PAGE_FRAME_FREE 0x1
+
+// 物理页框的描述信息，按物理页号索引
+struct PageFrame
+{
+    dword next;     // 空闲链表中下一个块的页号(相对于所在的BuddyPool)
+    dword previous; // 空闲链表中上一个块的页号(相对于所在的BuddyPool)
+    byte order;     // 空闲块的阶，只对空闲块的首个页框有效
+    byte flags;     // 页框状态
+    word refCount;  // 引用计数，写时复制的页会被多个进程共享
+    byte age;       // 用户页的年龄，每次老化右移一位，这段时间内被访问过则最高位置1
+};
+
+// 页框描述表，覆盖全部物理内存
+PageFrame *pageFrames;
+
+// 伙伴系统管理的物理地址池
+class BuddyPool
+{
+public:
+    dword startAddress;                        // 地址池的起始物理地址
+    dword length;                              // 地址池的页框数
+    dword freeCount;                           // 空闲页框数
+    dword usableCount;                         // 可用的页框数，不含内存空洞
+    dword freeLists[BUDDY_MAX_ORDER + 1];      // 每一阶的空闲链表
+
+public:
+    BuddyPool();
+    // 初始化，startAddress=起始物理地址，length=页框数，全部页框先置为不可用，
+    // 可用的页框再通过release加入，内存空洞中的页框不会被分配
+    void initialize(const dword startAddress, const dword length);
+    // 分配count个物理上连续的页，返回起始物理地址，若没有则返回-1
+    dword allocate(const dword count);
+    // 释放从address开始的amount个页
+    void release(const dword address, const dword amount);
+    // 判断address是否由此地址池管理
+    bool contains(const dword address);
+    // 最大的空闲块的页数
+    dword largestFree();
+
+private:
+    // 分配一个2^order页的块，返回块的相对页号，若没有则返回-1
+    dword allocateBlock(const dword order);
+    // 释放一个2^order页的块并与伙伴合并
+    void releaseBlock(dword index, dword order);
+    // 将[index, index + amount)拆分成对齐的块后释放
+    void releaseRange(dword index, const dword amount);
+    // 将块放入order阶的空闲链表
+    void pushFree(const dword index, const dword order);
+    // 将块从order阶的空闲链表中删除
+    void removeFree(const dword index, const dword order);
+    // 相对页号为index的页框
+    PageFrame *frame(const dword index);
+};
+
+#endif
@@ -1,44 +1,222 @@
 #include "memory.h"
 #include "../clib/cstdio.h"
 #include "../program/thread.h"
+#include "../clib/cstdlib.h"
+#include "../kernel/panic.h"
+#include "../kernel/interrupt.h"
+#include "../ext2/fs.h"
 
-void initMemoryPool(const dword totalMemory)
+void enableGlobalPages()
 {
+    kernelPageFlags = 0x7;
+
+    if (!(cpuFeatures & CPUID_PGE))
+        return;
+
+    kernelPageFlags |= PTE_GLOBAL;
+
+    // loader建立的内核页表项都改为全局的，页目录项中的G位无效，不需要修改
+    for (dword i = 768; i < 1023; ++i)
+    {
+        if (!(*toPDE(i << 22) & PTE_PRESENT) || (*toPDE(i << 22) & PDE_LARGE))
+            continue;
+
+        dword *pte = toPTE(i << 22);
+        for (dword j = 0; j < 1024; ++j)
+        {
+            if (pte[j] & PTE_PRESENT)
+            {
+                pte[j] |= PTE_GLOBAL;
+            }
+        }
+    }
+
+    sys_enable_global_pages();
+}
+
+void enableLargePages()
+{
+    directMapSize = 0;
+
+    if (!(cpuFeatures & CPUID_PSE))
+        return;
+
+    // 先设置PSE位，页目录项中的PS位才有效
+    sys_enable_large_pages();
+
+    // 内核映像所在的4MB仍使用loader的页表。用户进程运行在内核映像中的代码上，
+    // 这些页对用户可见，4MB的页会把低端1MB之外的页目录表、页表和页框描述表也暴露给用户。
+    // 物理内存的直接映射只供内核使用，loader为这些目录项分配的页表不再使用
+    for (dword offset = 0; offset < DIRECT_MAP_SIZE; offset += LARGE_PAGE_SIZE)
+    {
+        *toPDE(DIRECT_MAP_START + offset) = offset | PDE_LARGE | 0x3 | (kernelPageFlags & PTE_GLOBAL);
+        invalidatePage(DIRECT_MAP_START + offset);
+    }
+
+    directMapSize = DIRECT_MAP_SIZE;
+}
+
+void initMemoryPool()
+{
+    MemoryRegion regions[MEMORY_MAP_MAX_ENTRIES];
+    dword amount = getUsableRegions(regions, MEMORY_MAP_MAX_ENTRIES);
+
+    // 全局变量不调用构造函数
+    memset((byte *)&memoryCounters, 0, sizeof(MemoryCounters));
     dword usedMemory = 256 * PAGE_SIZE + 0x100000;
-    dword freeMemory = totalMemory - usedMemory;
 
-    dword freePages = freeMemory / PAGE_SIZE;
+    // 页框描述表覆盖到最高的可用地址，放在已使用的内存之后，映射到内核堆的开头
+    dword totalMemory = regions[amount - 1].end;
+    dword totalPages = totalMemory / PAGE_SIZE;
+    dword framePages = (totalPages * sizeof(PageFrame) + PAGE_SIZE - 1) / PAGE_SIZE;
+
+    pageFrames = (PageFrame *)KERNEL_HEAP_START;
+    for (dword i = 0; i < framePages; ++i)
+    {
+        // 内核的页表已由loader分配，这里不会再申请物理页
+        connectPhysicalVritualPage(KERNEL_HEAP_START + i * PAGE_SIZE, usedMemory + i * PAGE_SIZE);
+    }
+    usedMemory += framePages * PAGE_SIZE;
+
+    // 统计已使用的内存之后的可用页
+    dword freePages = 0;
+    for (dword i = 0; i < amount; ++i)
+    {
+        dword start = regions[i].start < usedMemory ? usedMemory : regions[i].start;
+        if (regions[i].end > start)
+        {
+            freePages += (regions[i].end - start) / PAGE_SIZE;
+        }
+    }
+
+    // 内核的物理页都要映射到内核堆，不能超过内核堆的大小和位图能表示的页数
     dword kernelPages = freePages / 2;
-    dword userPages = freePages - kernelPages;
+    dword kernelVirtualPages = (KERNEL_HEAP_END - KERNEL_HEAP_START) / PAGE_SIZE - framePages;
+    dword bitmapPages = (BITMAP_END_ADDRESS - BITMAP_START_ADDRESS) * 8;
+    if (kernelPages > kernelVirtualPages)
+    {
+        kernelPages = kernelVirtualPages;
+    }
+    if (kernelPages > bitmapPages)
+    {
+        kernelPages = bitmapPages;
+    }
 
+    // 按地址从低到高，前kernelPages个可用页归内核，其余归用户
     dword kernelPoolStartAddress = usedMemory;
-    dword userPoolStartAddress = usedMemory + kernelPages * PAGE_SIZE;
-
-    byte *kernelBitMapStart = (byte *)BITMAP_START_ADDRESS;
-    byte *userBitMapStart = kernelBitMapStart + kernelPages / 8;
-    if (kernelPages % 8)
-        ++userBitMapStart;
+    dword userPoolStartAddress = usedMemory;
+    dword remain = kernelPages;
+    for (dword i = 0; i < amount && remain; ++i)
+    {
+        dword start = regions[i].start < usedMemory ? usedMemory : regions[i].start;
+        if (regions[i].end <= start)
+            continue;
 
-    kernelPool.setResources(kernelBitMapStart, kernelPages);
-    kernelPool.setStartAddress(kernelPoolStartAddress);
+        dword pages = (regions[i].end - start) / PAGE_SIZE;
+        if (pages >= remain)
+        {
+            userPoolStartAddress = start + remain * PAGE_SIZE;
+            remain = 0;
+        }
+        else
+        {
+            userPoolStartAddress = regions[i].end;
+            remain -= pages;
+        }
+    }
 
-    userPool.setResources(userBitMapStart, userPages);
-    userPool.setStartAddress(userPoolStartAddress);
+    kernelPool.initialize(kernelPoolStartAddress, (userPoolStartAddress - kernelPoolStartAddress) / PAGE_SIZE);
+    userPool.initialize(userPoolStartAddress, (totalMemory - userPoolStartAddress) / PAGE_SIZE);
+    addUsableRegions(kernelPool, regions, amount);
+    addUsableRegions(userPool, regions, amount);
 
-    byte *kernelVrirtualBitMapStart = userBitMapStart + userPages / 8;
-    if (userPages % 8)
-        ++kernelVrirtualBitMapStart;
+    // 物理地址池由伙伴系统管理，位图只留给内核虚拟地址池
+    byte *kernelVrirtualBitMapStart = (byte *)BITMAP_START_ADDRESS;
     kernelVrirtualPool.setResources(kernelVrirtualBitMapStart, kernelPages);
-    kernelVrirtualPool.setStartAddress(KERNEL_HEAP_START);
+    kernelVrirtualPool.setStartAddress(KERNEL_HEAP_START + framePages * PAGE_SIZE);
+
+    // 临时映射的槽只占用虚拟地址，使用时再指向具体的物理页
+    kmapStart = (dword)allocateVirtualPages(AddressPoolType::KERNEL, KMAP_SLOTS);
+    kmapUsed = 0;
 
-    // printf("kernel pool\n    start address: %d\n    total pages: %d\n    bit map start address: %d\n",
-    //        kernelPoolStartAddress, kernelPages, kernelBitMapStart);
+    // printf("kernel pool\n    start address: %d\n    free pages: %d\n",
+    //        kernelPoolStartAddress, kernelPool.freeCount);
 
-    // printf("user pool\n    start address: %d\n    total pages: %d\n    bit map start address: %d\n",
-    //        userPoolStartAddress, userPages, userBitMapStart);
+    // printf("user pool\n    start address: %d\n    free pages: %d\n",
+    //        userPoolStartAddress, userPool.freeCount);
 
     // printf("kernel virtual pool\n    start address: %d\n    total pages: %d\n    bit map start address: %d\n",
-    //        KERNEL_HEAP_START, userPages, kernelVrirtualBitMapStart);
+    //        KERNEL_HEAP_START + framePages * PAGE_SIZE, kernelPages, kernelVrirtualBitMapStart);
+}
+
+dword getUsableRegions(MemoryRegion *regions, const dword maxAmount)
+{
+    dword amount = *(dword *)MEMORY_MAP_ADDRESS;
+    MemoryMapEntry *entries = (MemoryMapEntry *)(MEMORY_MAP_ADDRESS + 4);
+    dword count = 0;
+
+    if (amount > MEMORY_MAP_MAX_ENTRIES)
+    {
+        amount = MEMORY_MAP_MAX_ENTRIES;
+    }
+
+    for (dword i = 0; i < amount && count < maxAmount; ++i)
+    {
+        // 4GB以上的内存无法映射，直接忽略
+        if (entries[i].type != E820_USABLE || entries[i].baseHigh)
+            continue;
+
+        dword start = entries[i].baseLow;
+        dword end = start + entries[i].lengthLow;
+        if (entries[i].lengthHigh || end < start)
+        {
+            end = 0xfffff000;
+        }
+
+        // 只使用完整的页
+        start = (start + PAGE_SIZE - 1) & 0xfffff000;
+        end &= 0xfffff000;
+        if (end <= start)
+            continue;
+
+        // 插入排序，BIOS返回的内存块不保证有序
+        dword j = count;
+        while (j > 0 && regions[j - 1].start > start)
+        {
+            regions[j] = regions[j - 1];
+            --j;
+        }
+        regions[j].start = start;
+        regions[j].end = end;
+        ++count;
+    }
+
+    // BIOS不支持E820，按默认的内存大小处理
+    if (count == 0)
+    {
+        regions[0].start = 0;
+        regions[0].end = DEFAULT_MEMORY_SIZE;
+        count = 1;
+    }
+
+    return count;
+}
+
+void addUsableRegions(BuddyPool &pool, const MemoryRegion *regions, const dword amount)
+{
+    dword poolEnd = pool.startAddress + pool.length * PAGE_SIZE;
+
+    for (dword i = 0; i < amount; ++i)
+    {
+        dword start = regions[i].start < pool.startAddress ? pool.startAddress : regions[i].start;
+        dword end = regions[i].end > poolEnd ? poolEnd : regions[i].end;
+        if (end > start)
+        {
+            pool.release(start, (end - start) / PAGE_SIZE);
+        }
+    }
+
+    pool.usableCount = pool.freeCount;
 }
 
 void *allocateVirtualPages(enum AddressPoolType type, const dword count)
@@ -55,47 +233,100 @@ void *allocateVirtualPages(enum AddressPoolType type, const dword count)
         start = ptr->userVaddr.allocate(count);
     }
 
-    return (start == -1) ? nullptr : (void *)start;
+    return (start == (dword)-1) ? nullptr : (void *)start;
 }
 
-void *allocatePhysicalPage(enum AddressPoolType type)
+void *allocatePhysicalPage(enum AddressPoolType type, const bool zeroed)
 {
+    BuddyPool *pool;
+    ZeroPagePool *zeroPool;
+
+    if (type == AddressPoolType::KERNEL)
+    {
+        pool = &kernelPool;
+        zeroPool = &kernelZeroPool;
+    }
+    else if (type == AddressPoolType::USER)
+    {
+        pool = &userPool;
+        zeroPool = &userZeroPool;
+    }
+    else
+    {
+        return nullptr;
+    }
+
     dword start = -1;
 
+    if (zeroed)
+    {
+        // 预清零的页用完时才在这里清零
+        start = zeroPool->allocate();
+        if (start == (dword)-1)
+        {
+            start = pool->allocate(1);
+            if (start != (dword)-1)
+            {
+                clearPhysicalPage(start);
+            }
+        }
+    }
+    else
+    {
+        start = pool->allocate(1);
+        // 伙伴系统没有空闲页时，预清零的页也可以使用
+        if (start == (dword)-1)
+        {
+            start = zeroPool->allocate();
+        }
+    }
+
+    // 用户物理页用完时换出不常用的页后再分配
+    if (start == (dword)-1 && type == AddressPoolType::USER && reclaimUserPages())
+        return allocatePhysicalPage(type, zeroed);
+
+    if (start == (dword)-1)
+    {
+        ++memoryCounters.pageFailures;
+        return nullptr;
+    }
+
+    return (void *)start;
+}
+
+dword allocatePhysicalPages(enum AddressPoolType type, const dword count)
+{
     if (type == AddressPoolType::KERNEL)
     {
-        start = kernelPool.allocate(1);
+        return kernelPool.allocate(count);
     }
     else if (type == AddressPoolType::USER)
     {
-        start = userPool.allocate(1);
+        return userPool.allocate(count);
     }
 
-    return (start == -1) ? nullptr : (void *)start;
+    return -1;
 }
 
 bool connectPhysicalVritualPage(const dword virtualAddress, const dword physicalPageAddress)
 {
     dword *pde = toPDE(virtualAddress);
     dword *pte = toPTE(virtualAddress);
+    dword flags = virtualAddress >= 0xc0000000 ? kernelPageFlags : 0x7;
 
     if (*pde & 0x00000001)
     {
-        *pte = physicalPageAddress | 0x7;
+        *pte = physicalPageAddress | flags;
     }
     else
     {
-        void *ptr = allocatePhysicalPage(AddressPoolType::KERNEL);
+        // 新的页表必须是清零的
+        void *ptr = allocatePhysicalPage(AddressPoolType::KERNEL, true);
         if (ptr == nullptr)
             return false;
         dword pageAddress = (dword)ptr;
         *pde = pageAddress | 0x7;
-        byte *pagePtr = (byte *)(((dword)pte) & 0xfffff000);
-        for (int i = 0; i < PAGE_SIZE; ++i)
-        {
-            pagePtr[i] = 0;
-        }
-        *pte = physicalPageAddress | 0x7;
+        *pte = physicalPageAddress | flags;
     }
 
     return true;
@@ -110,7 +341,7 @@ dword *toPTE(const dword virtualAddress)
     return (dword *)(0xffc00000 + ((virtualAddress & 0xffc00000) >> 10) + (((virtualAddress & 0x003ff000) >> 12) * 4));
 }
 
-void *allocatePages(enum AddressPoolType type, const dword count)
+void *allocatePages(enum AddressPoolType type, const dword count, const bool zeroed)
 {
     dword virtualAddress = (dword)allocateVirtualPages(type, count);
     if (!virtualAddress)
@@ -119,23 +350,80 @@ void *allocatePages(enum AddressPoolType type, const dword count)
     dword physicalPageAddress;
     void *ans = (void *)virtualAddress;
 
-    for (int i = 0; i < count; ++i, virtualAddress += PAGE_SIZE)
+    for (dword i = 0; i < count; ++i, virtualAddress += PAGE_SIZE)
     {
-        physicalPageAddress = (dword)allocatePhysicalPage(type);
+        physicalPageAddress = (dword)allocatePhysicalPage(type, zeroed);
+        if (physicalPageAddress && !connectPhysicalVritualPage(virtualAddress, physicalPageAddress))
+        {
+            releasePhysicalPage(physicalPageAddress);
+            physicalPageAddress = 0;
+        }
         if (!physicalPageAddress)
         {
-            // 之前分配的也要回收
+            // 之前分配的也要回收，未映射部分的页表项可能残留着已释放的内核页，只归还虚拟地址
+            if (i)
+            {
+                releasePage(type, (dword)ans, i);
+            }
+            releaseVirtualPage(type, virtualAddress, count - i);
             return nullptr;
         }
-        if (!connectPhysicalVritualPage(virtualAddress, physicalPageAddress))
-            return nullptr;
     }
 
     return ans;
 }
 
+void *reservePages(enum AddressPoolType type, const dword count)
+{
+    // 内核空间的页错误不做处理，内核页仍然立即分配
+    if (type == AddressPoolType::KERNEL)
+        return allocatePages(type, count);
+
+    return allocateVirtualPages(type, count);
+}
+
+bool reservePagesAt(enum AddressPoolType type, const dword virtualAddress, const dword count)
+{
+    // 只有按需分配的用户页才能在指定位置保留
+    if (type == AddressPoolType::KERNEL)
+        return false;
+
+    PCB *pcb = sysProgramManager.running();
+    return pcb->userVaddr.allocateAt(virtualAddress, count);
+}
+
+void *allocateContiguousPages(enum AddressPoolType type, const dword count)
+{
+    dword virtualAddress = (dword)allocateVirtualPages(type, count);
+    if (!virtualAddress)
+        return nullptr;
+
+    dword physicalAddress = allocatePhysicalPages(type, count);
+    if (physicalAddress == (dword)-1)
+    {
+        releaseVirtualPage(type, virtualAddress, count);
+        return nullptr;
+    }
+
+    for (dword i = 0; i < count; ++i)
+    {
+        if (!connectPhysicalVritualPage(virtualAddress + i * PAGE_SIZE, physicalAddress + i * PAGE_SIZE))
+        {
+            releasePhysicalPages(physicalAddress, count);
+            releaseVirtualPage(type, virtualAddress, count);
+            return nullptr;
+        }
+    }
+
+    return (void *)virtualAddress;
+}
+
 dword vaddr2paddr(dword vaddr)
 {
+    dword pde = *toPDE(vaddr);
+    if (pde & PDE_LARGE)
+        return (pde & 0xffc00000) + (vaddr & 0x003fffff);
+
     return (((dword)(*(toPTE(vaddr))) & 0xfffff000) + (vaddr & 0xfff));
 }
 
@@ -149,48 +437,185 @@ void *specifyPaddrForVaddr(enum AddressPoolType type, const dword vaddr)
     return ans ? (void *)vaddr : nullptr;
 }
 
-void releasePage(const dword virtualAddress, const dword count)
+void releasePage(enum AddressPoolType type, const dword virtualAddress, const dword count)
 {
     //  物理地址是不连续的，虚拟地址是连续的
 
-    dword *pte = nullptr;
     dword temp = virtualAddress;
-    PCB *pcb = sysProgramManager.running();
+    // 内核页可能是全局页，重新加载cr3不能使其失效
+    bool flushAll = virtualAddress < 0xc0000000 && count > TLB_FLUSH_THRESHOLD;
 
-    for (int i = 0; i < count; ++i)
+    for (dword i = 0; i < count; ++i)
     {
-        releasePhysicalPage(vaddr2paddr(temp));
+        // 按需分配的页可能从未被访问过
+        if ((*toPDE(temp) & PTE_PRESENT) && (*toPTE(temp) & PTE_PRESENT))
+        {
+            releasePhysicalPage(vaddr2paddr(temp));
+            // 清除页表项，避免进程退出时再次释放
+            *toPTE(temp) = 0;
+            if (!flushAll)
+            {
+                invalidatePage(temp);
+            }
+        }
+        else if (isSwappedOut(temp))
+        {
+            releaseSwapSlot(*toPTE(temp));
+            *toPTE(temp) = 0;
+        }
         temp += PAGE_SIZE;
     }
 
-    releaseVirtualPage(virtualAddress, count);
+    if (flushAll)
+    {
+        sys_flush_tlb();
+    }
+
+    releaseVirtualPage(type, virtualAddress, count);
 }
 
 // 释放虚拟页
-void releaseVirtualPage(const dword vaddr, const dword count)
+void releaseVirtualPage(enum AddressPoolType type, const dword vaddr, const dword count)
 {
-    PCB *pcb = sysProgramManager.running();
-    if (pcb->pageDir)
+    // 和allocateVirtualPages对应，按地址池类型选择，内核堆可能在进程的系统调用中释放
+    if (type == AddressPoolType::KERNEL)
     {
-        pcb->userVaddr.release(vaddr, count);
+        kernelVrirtualPool.release(vaddr, count);
     }
-    else
+    else if (type == AddressPoolType::USER)
     {
-        kernelVrirtualPool.release(vaddr, count);
+        sysProgramManager.running()->userVaddr.release(vaddr, count);
     }
 }
-// 释放物理页
+// 释放物理页，共享的页只减少引用计数
 void releasePhysicalPage(const dword paddr)
 {
-    PCB *pcb = sysProgramManager.running();
+    PageFrame *frame = pageFrames + paddr / PAGE_SIZE;
 
-    if (pcb->pageDir)
+    bool status = _interrupt_status();
+    _disable_interrupt();
+
+    if (frame->refCount > 1)
     {
-        userPool.release(paddr, 1);
+        --frame->refCount;
+        _set_interrupt(status);
+        return;
     }
-    else
+
+    frame->refCount = 0;
+    _set_interrupt(status);
+
+    releasePhysicalPages(paddr, 1);
+}
+
+// 释放count个物理上连续的页，按地址找到所属的地址池
+void releasePhysicalPages(const dword paddr, const dword count)
+{
+    if (kernelPool.contains(paddr))
+    {
+        kernelPool.release(paddr, count);
+    }
+    else if (userPool.contains(paddr))
+    {
+        userPool.release(paddr, count);
+    }
+}
+
+void releasePhysicalPageBatch(const dword *paddrs, const dword count)
+{
+    bool status = _interrupt_status();
+    _disable_interrupt();
+
+    dword runStart = 0, runLength = 0;
+    for (dword i = 0; i < count; ++i)
+    {
+        PageFrame *frame = pageFrames + paddrs[i] / PAGE_SIZE;
+        if (frame->refCount > 1)
+        {
+            --frame->refCount;
+            continue;
+        }
+        frame->refCount = 0;
+
+        // 连续的一段不能跨越两个地址池
+        if (runLength && paddrs[i] == runStart + runLength * PAGE_SIZE &&
+            userPool.contains(paddrs[i]) == userPool.contains(runStart))
+        {
+            ++runLength;
+            continue;
+        }
+
+        if (runLength)
+        {
+            releasePhysicalPages(runStart, runLength);
+        }
+        runStart = paddrs[i];
+        runLength = 1;
+    }
+
+    if (runLength)
+    {
+        releasePhysicalPages(runStart, runLength);
+    }
+
+    _set_interrupt(status);
+}
+
+void releaseUserSpace(PCB *process)
+{
+    dword batch[FRAME_BATCH_SIZE];
+    dword count = 0;
+
+    // 用户页只会出现在区域表的区域中和栈中，没有映射的4MB直接跳过
+    VirtualAreaList &list = process->userVaddr;
+    for (dword i = 0; i < list.count; ++i)
     {
-        kernelPool.release(paddr, 1);
+        collectUserFrames(list.areas[i].start, list.areas[i].end, batch, count);
+    }
+    collectUserFrames(USER_STACK_LIMIT, 0xc0000000, batch, count);
+
+    // 0~767的页目录项对应用户空间的页表，页表并未从虚拟地址池中分配地址
+    for (dword i = 0; i < 768; ++i)
+    {
+        if (!(process->pageDir[i] & PTE_PRESENT))
+            continue;
+
+        batch[count++] = process->pageDir[i] & 0xfffff000;
+        if (count == FRAME_BATCH_SIZE)
+        {
+            releasePhysicalPageBatch(batch, count);
+            count = 0;
+        }
+    }
+
+    releasePhysicalPageBatch(batch, count);
+}
+
+void collectUserFrames(dword start, const dword end, dword *batch, dword &count)
+{
+    while (start < end)
+    {
+        if (!(*toPDE(start) & PTE_PRESENT))
+        {
+            start = (start & 0xffc00000) + 0x400000;
+            continue;
+        }
+
+        dword pte = *toPTE(start);
+        if (pte & PTE_SWAPPED)
+        {
+            releaseSwapSlot(pte);
+        }
+        else if (pte & PTE_PRESENT)
+        {
+            batch[count++] = pte & 0xfffff000;
+            if (count == FRAME_BATCH_SIZE)
+            {
+                releasePhysicalPageBatch(batch, count);
+                count = 0;
+            }
+        }
+        start += PAGE_SIZE;
     }
 }
 
@@ -198,15 +623,351 @@ void releaseKernelPage(const dword virtualAddress, const dword count)
 {
     //  物理地址是不连续的，虚拟地址是连续的
 
-    dword *pte = nullptr;
     dword temp = virtualAddress;
-    PCB *pcb = sysProgramManager.running();
 
-    for (int i = 0; i < count; ++i)
+    for (dword i = 0; i < count; ++i)
     {
         kernelPool.release(vaddr2paddr(temp), 1);
         temp += PAGE_SIZE;
     }
 
     kernelVrirtualPool.release(virtualAddress, count);
-}
\ No newline at end of file
+}
+void shareFrame(const dword paddr)
+{
+    bool status = _interrupt_status();
+    _disable_interrupt();
+    ++pageFrames[paddr / PAGE_SIZE].refCount;
+    _set_interrupt(status);
+}
+
+void invalidatePage(const dword virtualAddress)
+{
+    // 没有CPUID的早期处理器可能不支持invlpg
+    if (cpuFeatures)
+    {
+        sys_invlpg(virtualAddress);
+    }
+    else
+    {
+        sys_flush_tlb();
+    }
+}
+
+void *kmap(const dword paddr)
+{
+    if (paddr < directMapSize)
+        return (void *)(DIRECT_MAP_START + paddr);
+
+    bool status = _interrupt_status();
+    _disable_interrupt();
+
+    dword slot = 0;
+    while (slot < KMAP_SLOTS && (kmapUsed & (1 << slot)))
+        ++slot;
+
+    // 临时映射用完后立即解除，槽用尽说明有映射没有解除
+    if (slot == KMAP_SLOTS)
+    {
+        PANIC::halt(PANIC_KMAP_EXHAUSTED, "kmap", "no free kmap slot");
+    }
+    kmapUsed |= 1 << slot;
+
+    _set_interrupt(status);
+
+    // 槽已归当前线程所有，建立映射时不需要关中断
+    dword vaddr = kmapStart + slot * PAGE_SIZE;
+    *toPTE(vaddr) = paddr | 0x3 | (kernelPageFlags & PTE_GLOBAL);
+    invalidatePage(vaddr);
+
+    return (void *)vaddr;
+}
+
+void kunmap(const void *address)
+{
+    dword vaddr = (dword)address & 0xfffff000;
+
+    // 直接映射区不需要解除
+    if (vaddr >= DIRECT_MAP_START)
+        return;
+
+    *toPTE(vaddr) = 0;
+    invalidatePage(vaddr);
+
+    bool status = _interrupt_status();
+    _disable_interrupt();
+    kmapUsed &= ~(1 << ((vaddr - kmapStart) / PAGE_SIZE));
+    _set_interrupt(status);
+}
+
+bool demandPage(const dword virtualAddress)
+{
+    PCB *pcb = sysProgramManager.running();
+    if (!pcb || !pcb->pageDir)
+        return false;
+
+    // 栈区域内的访问使栈自动增长，堆区域只有已分配的虚拟页才能访问
+    if (virtualAddress >= 0xc0000000)
+        return false;
+
+    VirtualArea *area = pcb->userVaddr.find(virtualAddress);
+    if (virtualAddress < USER_STACK_LIMIT && !area)
+        return false;
+
+    dword paddr = (dword)allocatePhysicalPage(AddressPoolType::USER, true);
+    if (!paddr)
+        return false;
+
+    dword page = virtualAddress & 0xfffff000;
+    if (!connectPhysicalVritualPage(page, paddr))
+    {
+        releasePhysicalPage(paddr);
+        return false;
+    }
+
+    if (area && (area->flags & VMA_FILE))
+    {
+        // 从文件读入，文件末尾之后的部分保持为0
+        if (!sysFileSystem.readPage(area->file, area->offset + (page - area->start), (void *)page))
+        {
+            *toPTE(page) = 0;
+            invalidatePage(page);
+            releasePhysicalPage(paddr);
+            return false;
+        }
+
+        // 读入时内核写了这一页，清除脏位，只读的映射去掉写权限
+        *toPTE(page) &= ~PTE_DIRTY;
+        if (!(area->flags & VMA_WRITE))
+        {
+            *toPTE(page) &= ~PTE_WRITE;
+        }
+        invalidatePage(page);
+    }
+
+    return true;
+}
+
+bool copyOnWrite(const dword virtualAddress)
+{
+    dword *pte = toPTE(virtualAddress);
+    dword paddr = *pte & 0xfffff000;
+    PageFrame *frame = pageFrames + paddr / PAGE_SIZE;
+
+    // 其他进程都已经复制或退出，直接恢复写权限
+    if (frame->refCount == 1)
+    {
+        *pte = (*pte & ~PTE_COW) | PTE_WRITE;
+        invalidatePage(virtualAddress);
+        return true;
+    }
+
+    dword newPaddr = (dword)allocatePhysicalPage(AddressPoolType::USER);
+    if (!newPaddr)
+        return false;
+
+    // 分配时可能换出页并被调度走，共享的进程可能已经退出，页也可能已被换出
+    bool status = _interrupt_status();
+    _disable_interrupt();
+
+    if ((*pte & (0xfffff000 | PTE_PRESENT | PTE_COW)) != (paddr | PTE_PRESENT | PTE_COW) || frame->refCount == 1)
+    {
+        // 再次访问时重新处理
+        _set_interrupt(status);
+        releasePhysicalPage(newPaddr);
+        return true;
+    }
+
+    // 新的物理页不在当前地址空间中，通过临时映射写入
+    void *window = kmap(newPaddr);
+    copyPage((void *)(virtualAddress & 0xfffff000), window);
+    kunmap(window);
+
+    --frame->refCount;
+    ++memoryCounters.copyOnWrites;
+    *pte = (*pte & 0x00000fff & ~PTE_COW) | newPaddr | PTE_WRITE;
+    invalidatePage(virtualAddress);
+
+    _set_interrupt(status);
+    return true;
+}
+
+void *mapFile(const dword handle, const dword offset, const dword size, const dword flags)
+{
+    PCB *pcb = sysProgramManager.running();
+    if (!pcb->pageDir || !size || (offset & 0xfff))
+        return nullptr;
+
+    if (!sysFileSystem.isMappable(handle, flags & VMA_WRITE))
+        return nullptr;
+
+    // 页在第一次访问时才从文件读入
+    dword amount = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+    dword address = pcb->userVaddr.allocate(amount, VMA_READ | (flags & VMA_WRITE) | VMA_FILE, handle, offset);
+    if (address == (dword)-1)
+        return nullptr;
+
+    // 映射期间句柄被关闭后打开文件表的表项会被其他文件使用
+    referenceFile(handle, 1);
+    return (void *)address;
+}
+
+bool syncFile(const dword address, const dword size)
+{
+    VirtualArea *area = findFileArea(address, size);
+    if (!area)
+        return false;
+
+    return syncFilePages(area, address & 0xfffff000, address + size);
+}
+
+bool syncAllFiles()
+{
+    PCB *pcb = sysProgramManager.running();
+    if (!pcb->pageDir)
+        return false;
+
+    VirtualAreaList &list = pcb->userVaddr;
+    bool ans = true;
+
+    for (dword i = 0; i < list.count; ++i)
+    {
+        if ((list.areas[i].flags & VMA_FILE) && !syncFilePages(list.areas + i, list.areas[i].start, list.areas[i].end))
+        {
+            ans = false;
+        }
+    }
+
+    return ans;
+}
+
+bool unmapFile(const dword address, const dword size)
+{
+    if (address & 0xfff)
+        return false;
+
+    // 只能解除文件映射，共享内存段通过detachSharedSegment整体断开，
+    // 区域的结束地址按页对齐，范围在区域内时上取整到页后仍在区域内
+    VirtualArea *area = findFileArea(address, size);
+    if (!area || !syncFilePages(area, address, address + size))
+        return false;
+
+    // 整个区域被解除时放弃一个引用，从中间挖去一段时区域一分为二，多一个引用
+    VirtualAreaList &list = sysProgramManager.running()->userVaddr;
+    dword handle = area->file;
+    dword before = countFileAreas(list, handle);
+
+    releasePage(AddressPoolType::USER, address, (size + PAGE_SIZE - 1) / PAGE_SIZE);
+    referenceFile(handle, (int)countFileAreas(list, handle) - (int)before);
+    return true;
+}
+
+void shareFileMappings(PCB *process)
+{
+    VirtualAreaList &list = process->userVaddr;
+    for (dword i = 0; i < list.count; ++i)
+    {
+        if (list.areas[i].flags & VMA_FILE)
+        {
+            referenceFile(list.areas[i].file, 1);
+        }
+    }
+}
+
+void releaseFileMappings(PCB *process)
+{
+    VirtualAreaList &list = process->userVaddr;
+    for (dword i = 0; i < list.count; ++i)
+    {
+        if (list.areas[i].flags & VMA_FILE)
+        {
+            referenceFile(list.areas[i].file, -1);
+        }
+    }
+}
+
+VirtualArea *findFileArea(const dword address, const dword size)
+{
+    PCB *pcb = sysProgramManager.running();
+    if (!pcb->pageDir || !size || address + size < address)
+        return nullptr;
+
+    VirtualArea *area = pcb->userVaddr.find(address);
+    if (!area || !(area->flags & VMA_FILE) || address + size > area->end)
+        return nullptr;
+
+    return area;
+}
+
+dword countFileAreas(const VirtualAreaList &list, const dword handle)
+{
+    dword ans = 0;
+    for (dword i = 0; i < list.count; ++i)
+    {
+        if ((list.areas[i].flags & VMA_FILE) && list.areas[i].file == handle)
+        {
+            ++ans;
+        }
+    }
+    return ans;
+}
+
+void referenceFile(const dword handle, const int delta)
+{
+    bool status = _interrupt_status();
+    _disable_interrupt();
+    sysFileSystem.openedFiles[handle].count += delta;
+    _set_interrupt(status);
+}
+
+bool syncFilePages(const VirtualArea *area, const dword start, const dword end)
+{
+    for (dword page = start & 0xfffff000; page < end; page += PAGE_SIZE)
+    {
+        // 没有访问过或没有写过的页不需要写回
+        if (!(*toPDE(page) & PTE_PRESENT) ||
+            (*toPTE(page) & (PTE_PRESENT | PTE_DIRTY)) != (PTE_PRESENT | PTE_DIRTY))
+            continue;
+
+        if (!sysFileSystem.writePage(area->file, area->offset + (page - area->start), (void *)page))
+            return false;
+
+        *toPTE(page) &= ~PTE_DIRTY;
+        invalidatePage(page);
+    }
+
+    return true;
+}
+
+void pageFaultHandler(const dword address, const dword errorCode, const dword eflags)
+{
+    // 进入页错误处理时中断是关闭的。换入换出要读写硬盘，发生页错误的代码开着中断时，
+    // 处理期间也开中断，中断返回时恢复原来的eflags
+    ++memoryCounters.pageFaults;
+    if (eflags & 0x200)
+    {
+        _enable_interrupt();
+    }
+
+    if (!(errorCode & PAGE_FAULT_PRESENT))
+    {
+        // 访问被换出的页或未映射的页
+        if (isSwappedOut(address) ? swapIn(address) : demandPage(address))
+            return;
+    }
+    else if ((errorCode & PAGE_FAULT_WRITE) && (*toPTE(address) & PTE_COW))
+    {
+        if (copyOnWrite(address))
+            return;
+    }
+
+    // 用户态的非法访问只结束出错的进程，不会返回
+    if ((errorCode & PAGE_FAULT_USER) && sysProgramManager.running()->pageDir)
+    {
+        printf("process %d: page fault at 0x%x, error code: %d\n", sysProgramManager.running()->pid, address, errorCode);
+        sysProgramManager.exit(-1);
+    }
+
+    printf("page fault at 0x%x, error code: %d\n", address, errorCode);
+    PANIC::halt(PANIC_PAGE_FAULT, "pageFaultHandler", "unhandled page fault");
+}
@@ -3,47 +3,187 @@
 
 #include "../kernel/type.h"
 #include "../datastructure/bitmap.h"
+#include "buddy.h"
+#include "zero_pool.h"
+#include "swap.h"
+#include "stats.h"
 
 #include "../program/addresspool.h"
 #include "../program/program_manager.h"
 #include "../program/sync.h"
 
 #define BITMAP_START_ADDRESS 0xc0010000
+// 位图之后是中断描述符表
+#define BITMAP_END_ADDRESS 0xc0018800
 #define PAGE_SIZE 4096
-#define KERNEL_HEAP_START 0xc0100000
+// 内核堆从第二个4MB开始，0xc0000000开始的4MB是内核映像和低端内存
+#define KERNEL_HEAP_START 0xc0400000
+// 内核堆的结束地址，之后是物理内存的直接映射
+#define KERNEL_HEAP_END 0xf0000000
+// 物理内存[0, DIRECT_MAP_SIZE)直接映射到DIRECT_MAP_START，使用4MB的页，用户不可访问，
+// 之后是页目录表和页表的映射
+#define DIRECT_MAP_START 0xf0000000
+#define DIRECT_MAP_SIZE (0xffc00000 - DIRECT_MAP_START)
+// 4MB的页
+#define LARGE_PAGE_SIZE 0x400000
 
-AddressPool kernelVrirtualPool, kernelPool, userPool;
+// loader通过E820获取的内存布局，首个双字是内存块数，其后是各内存块
+#define MEMORY_MAP_ADDRESS 0xc0009000
+#define MEMORY_MAP_MAX_ENTRIES 32
+// 可用的内存块
+#define E820_USABLE 1
+// BIOS不支持E820时假设的内存大小，32MB，bochs内置
+#define DEFAULT_MEMORY_SIZE 0x2000000
 
-// 初始化地址池
-void initMemoryPool(const dword totalMemory);
+// E820返回的内存块
+struct MemoryMapEntry
+{
+    dword baseLow, baseHigh;      // 基地址
+    dword lengthLow, lengthHigh;  // 长度
+    dword type;                   // 类型
+};
+
+// 按页对齐的可用物理内存区域[start, end)
+struct MemoryRegion
+{
+    dword start;
+    dword end;
+};
+
+// 页表项的标志位
+#define PTE_PRESENT 0x1
+#define PTE_WRITE 0x2
+// 页目录项直接映射4MB的页
+#define PDE_LARGE 0x80
+// 全局页，重新加载cr3时TLB项不会被清除
+#define PTE_GLOBAL 0x100
+// 页被访问过
+#define PTE_ACCESSED 0x20
+// 页被写过
+#define PTE_DIRTY 0x40
+// 写时复制的页，使用页表项中留给操作系统的第9位
+#define PTE_COW 0x200
+// 被换出的页，P位为0，使用留给操作系统的第10位，高20位是交换槽号
+#define PTE_SWAPPED 0x400
+
+// 释放的用户页多于此数时重新加载cr3，否则逐页使TLB项失效
+#define TLB_FLUSH_THRESHOLD 32
+
+// 进程退出时每批归还的物理页数
+#define FRAME_BATCH_SIZE 64
+
+// 临时映射的槽数，同时使用的临时映射不超过此数
+#define KMAP_SLOTS 8
+
+// 页错误的错误码
+#define PAGE_FAULT_PRESENT 0x1
+#define PAGE_FAULT_WRITE 0x2
+#define PAGE_FAULT_USER 0x4
+
+extern "C" void sys_flush_tlb();
+extern "C" void sys_invlpg(dword address);
+extern "C" void sys_enable_global_pages();
+extern "C" void sys_enable_large_pages();
+
+AddressPool kernelVrirtualPool;
+BuddyPool kernelPool, userPool;
+// 临时映射槽的起始虚拟地址，用于访问没有映射到当前地址空间的物理页
+dword kmapStart;
+// 正在使用的槽，每位对应一个槽
+dword kmapUsed;
+// 内核页表项的属性，支持PGE时内核页是全局的
+dword kernelPageFlags;
+// 直接映射的物理内存大小，不支持PSE时为0
+dword directMapSize;
+
+// CPU支持PGE时将内核页设为全局页，需要在initMemoryOperations之后调用
+void enableGlobalPages();
+// CPU支持PSE时使用4MB的页建立物理内存的直接映射，需要在enableGlobalPages之后调用
+void enableLargePages();
+// 根据loader获取的内存布局初始化地址池
+void initMemoryPool();
+// 从E820内存布局中整理出4GB以下的可用内存区域，按地址排序，返回区域个数
+dword getUsableRegions(MemoryRegion *regions, const dword maxAmount);
+// 将可用内存区域中位于pool管理范围内的部分加入pool
+static void addUsableRegions(BuddyPool &pool, const MemoryRegion *regions, const dword amount);
 // 从虚拟地址池中分配count个连续页
 static void *allocateVirtualPages(enum AddressPoolType type, const dword count);
-// 从物理地址池中分配1个页
-static void *allocatePhysicalPage(enum AddressPoolType type);
+// 从物理地址池中分配1个页，zeroed为true时返回已清零的页
+static void *allocatePhysicalPage(enum AddressPoolType type, const bool zeroed = false);
+// 从物理地址池中分配count个物理上连续的页，返回起始物理地址
+dword allocatePhysicalPages(enum AddressPoolType type, const dword count);
 // 建立虚拟地址和物理地址的联系
 static bool connectPhysicalVritualPage(const dword virtualAddress, const dword physicalPageAddress);
 // 获取virtualAddress对应的PDE虚拟地址
 static dword *toPDE(const dword virtualAddress);
 // 获取virtualAddress对应的PTE虚拟地址T
 static dword *toPTE(const dword virtualAddress);
-// 分配count个连续的页地址空间并返回起始地址
-void *allocatePages(enum AddressPoolType type, const dword count);
+// 分配count个连续的页地址空间并返回起始地址，zeroed为true时页已清零
+void *allocatePages(enum AddressPoolType type, const dword count, const bool zeroed = false);
+// 只分配count个连续的用户虚拟页，物理页在第一次访问时再分配
+void *reservePages(enum AddressPoolType type, const dword count);
+// 保留从virtualAddress开始的count个用户虚拟页，若其中有页已被占用则返回false
+bool reservePagesAt(enum AddressPoolType type, const dword virtualAddress, const dword count);
+// 分配count个虚拟地址和物理地址都连续的页并返回起始虚拟地址
+void *allocateContiguousPages(enum AddressPoolType type, const dword count);
 // 返回虚拟地址对应的物理地址
 dword vaddr2paddr(dword vaddr);
 // 为指定的虚拟地址分配物理地址
 void *specifyPaddrForVaddr(enum AddressPoolType type, const dword vaddr);
 // 释放物理地址
 void releasePhysicalPage(dword address);
-// 释放虚拟地址
-void releaseVirtualPage(dword address);
-// 释放空间
-void releasePage(const dword virtualAddress, const dword count);
+// 释放type地址池中从virtualAddress开始的count个页，包括映射的物理页和虚拟地址
+void releasePage(enum AddressPoolType type, const dword virtualAddress, const dword count);
 // 归还从内核空间中分配的页
 void releaseKernelPage(const dword virtualAddress, const dword count);
 
-// 释放虚拟页
-void releaseVirtualPage(const dword vaddr, const dword count);
+// 将count个虚拟页还给type对应的虚拟地址池
+void releaseVirtualPage(enum AddressPoolType type, const dword vaddr, const dword count);
 // 释放物理页
 void releasePhysicalPage(const dword paddr);
+// 释放count个物理上连续的页
+void releasePhysicalPages(const dword paddr, const dword count);
+// 释放count个物理页，引用计数降为0的页中物理上连续的一段一起归还
+void releasePhysicalPageBatch(const dword *paddrs, const dword count);
+// 释放当前进程用户空间的物理页和页表，只遍历区域表中的区域和栈
+void releaseUserSpace(PCB *process);
+// 将[start, end)中已映射的物理页加入batch，batch满时成批释放，换出的页释放交换槽
+static void collectUserFrames(dword start, const dword end, dword *batch, dword &count);
+// 物理页多了一个共享者，引用计数加1
+void shareFrame(const dword paddr);
+// 使virtualAddress所在页的TLB项失效
+void invalidatePage(const dword virtualAddress);
+// 将物理页paddr临时映射到内核空间，返回映射的虚拟地址，不改变当前的地址空间，
+// 直接映射区中的物理页不占用临时映射的槽
+void *kmap(const dword paddr);
+// 解除kmap建立的临时映射
+void kunmap(const void *address);
+// 为已保留但未映射的用户页virtualAddress分配一个清零的物理页
+bool demandPage(const dword virtualAddress);
+// 为写时复制的页virtualAddress复制一个私有的物理页
+bool copyOnWrite(const dword virtualAddress);
+// 将当前进程打开的文件handle从offset开始的size个字节映射到用户空间，返回起始地址，
+// offset按页对齐，flags为VMA_READ或VMA_READ | VMA_WRITE，每个映射区域持有打开文件的一个引用，失败返回nullptr
+void *mapFile(const dword handle, const dword offset, const dword size, const dword flags);
+// 将[address, address + size)中的脏页写回文件，范围必须位于同一个文件映射区域内
+bool syncFile(const dword address, const dword size);
+// 将当前进程所有文件映射区域的脏页写回文件
+bool syncAllFiles();
+// 写回脏页后解除[address, address + size)的映射，范围必须位于同一个文件映射区域内
+bool unmapFile(const dword address, const dword size);
+// fork后子进程的文件映射区域也各持有打开文件的一个引用
+void shareFileMappings(PCB *process);
+// 进程退出时放弃文件映射区域对打开文件的引用
+void releaseFileMappings(PCB *process);
+// 返回完整包含[address, address + size)的文件映射区域，若没有则返回nullptr
+static VirtualArea *findFileArea(const dword address, const dword size);
+// 将文件映射区域area中[start, end)内的脏页写回文件
+static bool syncFilePages(const VirtualArea *area, const dword start, const dword end);
+// 区域表list中映射文件handle的区域数
+static dword countFileAreas(const VirtualAreaList &list, const dword handle);
+// 打开文件handle的引用数增加delta
+static void referenceFile(const dword handle, const int delta);
+// 页错误处理函数，address为引起页错误的地址，eflags为发生页错误时的标志寄存器
+extern "C" void pageFaultHandler(const dword address, const dword errorCode, const dword eflags);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,241 @@
+#include "shm.h"
+#include "memory.h"
+#include "../kernel/interrupt.h"
+
+void initSharedSegments()
+{
+    // 全局变量不调用构造函数
+    for (dword i = 0; i < SHM_MAX_SEGMENTS; ++i)
+    {
+        sharedSegments[i].key = 0;
+        sharedSegments[i].pages = 0;
+        sharedSegments[i].frames = nullptr;
+        sharedSegments[i].attached = 0;
+        sharedSegments[i].removed = false;
+    }
+}
+
+dword getSharedSegment(const dword key, const dword size)
+{
+    if (!key)
+        return -1;
+
+    bool status = _interrupt_status();
+    _disable_interrupt();
+
+    dword id = -1;
+    for (dword i = 0; i < SHM_MAX_SEGMENTS; ++i)
+    {
+        // 已移除的段不再被查找，相同的键会创建新段
+        if (sharedSegments[i].key == key && !sharedSegments[i].removed)
+        {
+            _set_interrupt(status);
+            return i;
+        }
+
+        if (!sharedSegments[i].key && id == (dword)-1)
+        {
+            id = i;
+        }
+    }
+
+    dword pages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+    if (id == (dword)-1 || !pages || pages > SHM_MAX_PAGES)
+    {
+        _set_interrupt(status);
+        return -1;
+    }
+
+    SharedSegment *segment = sharedSegments + id;
+    segment->frames = (dword *)allocatePages(AddressPoolType::KERNEL, 1);
+    if (!segment->frames)
+    {
+        _set_interrupt(status);
+        return -1;
+    }
+
+    // 共享内存的初始内容为0
+    for (dword i = 0; i < pages; ++i)
+    {
+        segment->frames[i] = (dword)allocatePhysicalPage(AddressPoolType::USER, true);
+        if (!segment->frames[i])
+        {
+            while (i)
+            {
+                releasePhysicalPage(segment->frames[--i]);
+            }
+            releaseKernelPage((dword)segment->frames, 1);
+            segment->frames = nullptr;
+            _set_interrupt(status);
+            return -1;
+        }
+    }
+
+    segment->key = key;
+    segment->pages = pages;
+    segment->attached = 0;
+    segment->removed = false;
+
+    _set_interrupt(status);
+    return id;
+}
+
+void *attachSharedSegment(const dword id)
+{
+    PCB *pcb = sysProgramManager.running();
+    if (!pcb->pageDir || id >= SHM_MAX_SEGMENTS)
+        return nullptr;
+
+    bool status = _interrupt_status();
+    _disable_interrupt();
+
+    SharedSegment *segment = sharedSegments + id;
+    if (!segment->key || segment->removed)
+    {
+        _set_interrupt(status);
+        return nullptr;
+    }
+
+    // 段号记录在区域的file中，共享区域的页不参与写时复制
+    dword address = pcb->userVaddr.allocate(segment->pages, VMA_READ | VMA_WRITE | VMA_SHARED, id);
+    if (address == (dword)-1)
+    {
+        _set_interrupt(status);
+        return nullptr;
+    }
+
+    for (dword i = 0; i < segment->pages; ++i)
+    {
+        if (!connectPhysicalVritualPage(address + i * PAGE_SIZE, segment->frames[i]))
+        {
+            // 已映射的页各持有一个引用，由releasePage归还
+            releasePage(AddressPoolType::USER, address, segment->pages);
+            _set_interrupt(status);
+            return nullptr;
+        }
+        shareFrame(segment->frames[i]);
+    }
+
+    ++(segment->attached);
+
+    _set_interrupt(status);
+    return (void *)address;
+}
+
+bool detachSharedSegment(const dword address)
+{
+    PCB *pcb = sysProgramManager.running();
+    if (!pcb->pageDir)
+        return false;
+
+    bool status = _interrupt_status();
+    _disable_interrupt();
+
+    VirtualArea *area = pcb->userVaddr.find(address);
+    if (!area || !(area->flags & VMA_SHARED) || area->start != address)
+    {
+        _set_interrupt(status);
+        return false;
+    }
+
+    dword id = area->file;
+    releasePage(AddressPoolType::USER, address, (area->end - area->start) / PAGE_SIZE);
+    dropSharedSegment(id);
+
+    _set_interrupt(status);
+    return true;
+}
+
+bool removeSharedSegment(const dword id)
+{
+    if (id >= SHM_MAX_SEGMENTS)
+        return false;
+
+    bool status = _interrupt_status();
+    _disable_interrupt();
+
+    SharedSegment *segment = sharedSegments + id;
+    if (!segment->key || segment->removed)
+    {
+        _set_interrupt(status);
+        return false;
+    }
+
+    if (segment->attached)
+    {
+        segment->removed = true;
+    }
+    else
+    {
+        freeSharedSegment(segment);
+    }
+
+    _set_interrupt(status);
+    return true;
+}
+
+void inheritSharedSegments(PCB *child)
+{
+    bool status = _interrupt_status();
+    _disable_interrupt();
+
+    VirtualAreaList &list = child->userVaddr;
+    for (dword i = 0; i < list.count; ++i)
+    {
+        if (list.areas[i].flags & VMA_SHARED)
+        {
+            ++(sharedSegments[list.areas[i].file].attached);
+        }
+    }
+
+    _set_interrupt(status);
+}
+
+bool isSharedPage(PCB *process, const dword address)
+{
+    VirtualArea *area = process->userVaddr.find(address);
+    return area && (area->flags & (VMA_SHARED | VMA_FILE));
+}
+
+void detachSharedSegments(PCB *process)
+{
+    bool status = _interrupt_status();
+    _disable_interrupt();
+
+    VirtualAreaList &list = process->userVaddr;
+    for (dword i = 0; i < list.count; ++i)
+    {
+        if (list.areas[i].flags & VMA_SHARED)
+        {
+            dropSharedSegment(list.areas[i].file);
+        }
+    }
+
+    _set_interrupt(status);
+}
+
+void dropSharedSegment(const dword id)
+{
+    SharedSegment *segment = sharedSegments + id;
+
+    --(segment->attached);
+    if (segment->attached)
+        return;
+
+    freeSharedSegment(segment);
+}
+
+void freeSharedSegment(SharedSegment *segment)
+{
+    // 归还段持有的引用，仍被映射的页在最后一个页表项释放时归还
+    for (dword i = 0; i < segment->pages; ++i)
+    {
+        releasePhysicalPage(segment->frames[i]);
+    }
+    releaseKernelPage((dword)segment->frames, 1);
+
+    segment->key = 0;
+    segment->pages = 0;
+    segment->frames = nullptr;
+    segment->removed = false;
+}
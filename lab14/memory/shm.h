@@ -0,0 +1,50 @@
+#ifndef SHM_H
+#define SHM_H
+
+#include "../configure/type.h"
+#include "../configure/os_configure.h"
+
+// 共享内存段的最大个数
+#define SHM_MAX_SEGMENTS 16
+// 每个段的最大页数，段的物理页号表占用一个内核页
+#define SHM_MAX_PAGES (PAGE_SIZE / sizeof(dword))
+
+struct PCB;
+
+// 共享内存段，段的物理页在创建时分配，映射到各进程的页表中。
+// 段本身持有每个物理页的一个引用，每次连接再增加一个引用，
+// 最后一个连接断开或未连接的段被移除时段被删除
+struct SharedSegment
+{
+    dword key;      // 段的键，0表示段未使用
+    dword pages;    // 页数
+    dword *frames;  // 各页的物理地址
+    dword attached; // 连接到本段的区域个数
+    bool removed;   // 段已被移除，不能再被查找和连接，等待最后一个连接断开
+};
+
+SharedSegment sharedSegments[SHM_MAX_SEGMENTS];
+
+// 初始化共享内存段表
+void initSharedSegments();
+// 返回键为key的段号，不存在时创建size字节的段，失败返回-1
+dword getSharedSegment(const dword key, const dword size);
+// 将段id映射到当前进程，返回起始地址，失败返回nullptr
+void *attachSharedSegment(const dword id);
+// 断开当前进程在address处的连接
+bool detachSharedSegment(const dword address);
+// 移除段id，未连接的段立即删除，否则在最后一个连接断开时删除
+bool removeSharedSegment(const dword id);
+// fork后子进程继承了父进程的连接
+void inheritSharedSegments(PCB *child);
+// 地址address是否属于多个进程共享的区域，共享内存段和文件映射在fork后都是共享的
+bool isSharedPage(PCB *process, const dword address);
+// 进程退出时断开所有连接，物理页由页表的释放过程归还
+void detachSharedSegments(PCB *process);
+
+// 连接数减一，减到0时删除段
+static void dropSharedSegment(const dword id);
+// 归还段的物理页和物理页号表
+static void freeSharedSegment(SharedSegment *segment);
+
+#endif
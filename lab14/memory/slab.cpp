@@ -0,0 +1,184 @@
+#include "slab.h"
+#include "memory.h"
+#include "../kernel/interrupt.h"
+
+SlabCache::SlabCache()
+{
+    initialize("", sizeof(void *));
+}
+
+void SlabCache::initialize(const char *name, const dword objectSize)
+{
+    int i;
+    for (i = 0; i < SLAB_NAME_LENGTH - 1 && name[i]; ++i)
+    {
+        this->name[i] = name[i];
+    }
+    this->name[i] = '\0';
+
+    // 空闲时对象要存放链表指针，对象按4字节对齐
+    dword size = objectSize < sizeof(void *) ? sizeof(void *) : objectSize;
+    this->objectSize = (size + 3) & ~3u;
+    this->objectsPerPage = (PAGE_SIZE - sizeof(SlabPage)) / this->objectSize;
+
+    partial = full = empty = nullptr;
+    emptyPages = 0;
+    next = nullptr;
+
+    pages = 0;
+    objectsInUse = 0;
+    allocations = 0;
+    releases = 0;
+    failures = 0;
+}
+
+void *SlabCache::allocate()
+{
+    bool status = _interrupt_status();
+    _disable_interrupt();
+
+    SlabPage *slab = partial;
+    if (!slab)
+    {
+        // 优先使用保留的空页
+        slab = empty;
+        if (slab)
+        {
+            unlink(&empty, slab);
+            --emptyPages;
+        }
+        else
+        {
+            slab = grow();
+        }
+
+        if (!slab)
+        {
+            ++failures;
+            _set_interrupt(status);
+            return nullptr;
+        }
+
+        link(&partial, slab);
+    }
+
+    void *object = slab->freeObjects;
+    slab->freeObjects = *(void **)object;
+    ++(slab->inUse);
+
+    if (slab->inUse == objectsPerPage)
+    {
+        unlink(&partial, slab);
+        link(&full, slab);
+    }
+
+    ++objectsInUse;
+    ++allocations;
+
+    _set_interrupt(status);
+    return object;
+}
+
+void SlabCache::release(void *object)
+{
+    // slab按页对齐，对象所在页的页首就是slab的描述信息
+    SlabPage *slab = (SlabPage *)((dword)object & 0xfffff000);
+
+    bool status = _interrupt_status();
+    _disable_interrupt();
+
+    *(void **)object = slab->freeObjects;
+    slab->freeObjects = object;
+
+    if (slab->inUse == objectsPerPage)
+    {
+        unlink(&full, slab);
+        link(&partial, slab);
+    }
+    --(slab->inUse);
+
+    --objectsInUse;
+    ++releases;
+
+    if (slab->inUse == 0)
+    {
+        unlink(&partial, slab);
+
+        if (emptyPages < SLAB_MAX_EMPTY_PAGES)
+        {
+            link(&empty, slab);
+            ++emptyPages;
+        }
+        else
+        {
+            --pages;
+            releaseKernelPage((dword)slab, 1);
+        }
+    }
+
+    _set_interrupt(status);
+}
+
+SlabPage *SlabCache::grow()
+{
+    SlabPage *slab = (SlabPage *)allocatePages(AddressPoolType::KERNEL, 1);
+    if (!slab)
+        return nullptr;
+
+    slab->cache = this;
+    slab->previous = slab->next = nullptr;
+    slab->inUse = 0;
+
+    // 将页内的对象串成空闲链表
+    dword address = (dword)slab + sizeof(SlabPage);
+    slab->freeObjects = (void *)address;
+    for (dword i = 0; i + 1 < objectsPerPage; ++i, address += objectSize)
+    {
+        *(void **)address = (void *)(address + objectSize);
+    }
+    *(void **)address = nullptr;
+
+    ++pages;
+    return slab;
+}
+
+void SlabCache::unlink(SlabPage **list, SlabPage *slab)
+{
+    if (slab->previous)
+    {
+        slab->previous->next = slab->next;
+    }
+    else
+    {
+        *list = slab->next;
+    }
+
+    if (slab->next)
+    {
+        slab->next->previous = slab->previous;
+    }
+
+    slab->previous = slab->next = nullptr;
+}
+
+void SlabCache::link(SlabPage **list, SlabPage *slab)
+{
+    slab->previous = nullptr;
+    slab->next = *list;
+
+    if (*list)
+    {
+        (*list)->previous = slab;
+    }
+    *list = slab;
+}
+
+void initSlabCaches()
+{
+    // 全局变量不调用构造函数
+    slabCaches = nullptr;
+
+    sectorCache.initialize("sector", SECTOR_SIZE);
+    sectorCache.next = slabCaches;
+    slabCaches = &sectorCache;
+}
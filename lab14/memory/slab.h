@@ -0,0 +1,70 @@
+#ifndef SLAB_H
+#define SLAB_H
+
+#include "../configure/type.h"
+#include "../configure/os_configure.h"
+
+// 缓存名的最大长度
+#define SLAB_NAME_LENGTH 16
+// 每个缓存最多保留的空页数，多余的空页归还内核
+#define SLAB_MAX_EMPTY_PAGES 1
+
+class SlabCache;
+
+// 每个slab占用一个内核页，页首是描述信息，其后是大小相同的对象
+struct SlabPage
+{
+    SlabCache *cache;             // 所属的缓存
+    SlabPage *previous, *next;    // 在缓存的partial/full/empty链表中的位置
+    void *freeObjects;            // 页内空闲对象链表，链表指针保存在空闲对象的首4个字节
+    dword inUse;                  // 已分配的对象数
+};
+
+// 固定大小对象的缓存，分配和释放只是在空闲对象链表上的一次操作，不调用构造函数
+class SlabCache
+{
+public:
+    char name[SLAB_NAME_LENGTH];  // 缓存名
+    dword objectSize;             // 对象大小
+    dword objectsPerPage;         // 每个slab的对象数
+    SlabPage *partial;            // 部分分配的slab
+    SlabPage *full;               // 全部分配的slab
+    SlabPage *empty;              // 全部空闲的slab
+    dword emptyPages;             // 空闲slab的个数
+    SlabCache *next;              // 所有缓存串成链表，便于统计
+
+    // 统计信息
+    dword pages;                  // 占用的页数
+    dword objectsInUse;           // 正在使用的对象数
+    dword allocations;            // 累计分配次数
+    dword releases;               // 累计释放次数
+    dword failures;               // 分配失败次数
+
+public:
+    SlabCache();
+    // 初始化，name=缓存名，objectSize=对象大小
+    void initialize(const char *name, const dword objectSize);
+    // 分配一个对象，若没有内存则返回nullptr
+    void *allocate();
+    // 释放由本缓存分配的对象
+    void release(void *object);
+
+private:
+    // 申请一个新的slab
+    SlabPage *grow();
+    // 从链表中删除slab
+    void unlink(SlabPage **list, SlabPage *slab);
+    // 将slab放到链表的头部
+    void link(SlabPage **list, SlabPage *slab);
+};
+
+// 所有缓存组成的链表
+SlabCache *slabCaches;
+
+// 磁盘扇区缓冲区
+SlabCache sectorCache;
+
+// 初始化内核对象缓存
+void initSlabCaches();
+
+#endif
@@ -0,0 +1,40 @@
+#include "stats.h"
+#include "memory.h"
+#include "../kernel/interrupt.h"
+
+void getMemoryStats(MemoryStats *stats)
+{
+    memset((byte *)stats, 0, sizeof(MemoryStats));
+
+    bool status = _interrupt_status();
+    _disable_interrupt();
+
+    stats->kernelPool.total = kernelPool.usableCount;
+    stats->kernelPool.free = kernelPool.freeCount;
+    stats->kernelPool.largestFree = kernelPool.largestFree();
+
+    stats->userPool.total = userPool.usableCount;
+    stats->userPool.free = userPool.freeCount;
+    stats->userPool.largestFree = userPool.largestFree();
+
+    stats->kernelVirtualPool.total = kernelVrirtualPool.resources.length;
+    stats->kernelVirtualPool.free = kernelVrirtualPool.resources.freeCount;
+    stats->kernelVirtualPool.largestFree = kernelVrirtualPool.resources.largestFreeRun();
+
+    stats->zeroPages = kernelZeroPool.count + userZeroPool.count;
+    stats->swapPages = swapFirstSlot < SWAP_MAX_SLOTS ? SWAP_MAX_SLOTS - swapFirstSlot : 0;
+    stats->swapUsed = swapUsedSlots;
+    stats->counters = memoryCounters;
+
+    _set_interrupt(status);
+
+    stats->kernelEmptyArenas = sysMemoryManager.statistics(stats->kernelArenas);
+    stats->kernelHeapFailures = sysMemoryManager.failures;
+
+    PCB *pcb = sysProgramManager.running();
+    if (pcb->pageDir)
+    {
+        stats->userEmptyArenas = pcb->memoryManager.statistics(stats->userArenas);
+        stats->userHeapFailures = pcb->memoryManager.failures;
+    }
+}
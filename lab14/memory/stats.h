@@ -0,0 +1,51 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include "../configure/type.h"
+#include "../configure/os_configure.h"
+#include "../program/thread.h"
+
+// 内存事件的计数
+struct MemoryCounters
+{
+    dword pageFaults;     // 页错误次数
+    dword copyOnWrites;   // 写时复制的页数
+    dword forks;          // fork复制地址空间的次数
+    dword forkPageTables; // fork复制的页表数
+    dword swapIns;        // 换入的页数
+    dword swapOuts;       // 换出的页数
+    dword pageFailures;   // 物理页分配失败的次数
+};
+
+// 地址池的统计信息，单位为页
+struct PoolStats
+{
+    dword total;       // 总页数
+    dword free;        // 空闲页数
+    dword largestFree; // 最大的连续空闲页数
+};
+
+// 内存统计信息的快照，由getMemoryStats填写
+struct MemoryStats
+{
+    PoolStats kernelPool;        // 内核物理页
+    PoolStats userPool;          // 用户物理页
+    PoolStats kernelVirtualPool; // 内核虚拟页
+    dword zeroPages;             // 预清零页池中的页数
+    dword swapPages;             // 交换区的页数
+    dword swapUsed;              // 已使用的交换页数
+    MemoryCounters counters;
+
+    // 内核堆和当前进程的堆，线程没有用户堆，对应的项全为0
+    dword kernelHeapFailures, userHeapFailures;
+    dword kernelEmptyArenas, userEmptyArenas;
+    ArenaStats kernelArenas[MemoryManager::MEM_BLOCK_TYPES];
+    ArenaStats userArenas[MemoryManager::MEM_BLOCK_TYPES];
+};
+
+MemoryCounters memoryCounters;
+
+// 将各地址池、交换区、计数和堆的统计信息写入stats
+void getMemoryStats(MemoryStats *stats);
+
+#endif
@@ -0,0 +1,263 @@
+#include "swap.h"
+#include "memory.h"
+#include "../disk/disk.h"
+#include "../kernel/interrupt.h"
+
+void initSwap()
+{
+    // 全局变量不调用构造函数
+    memset((byte *)swapSlots, 0, sizeof(swapSlots));
+    swapUsedSlots = 0;
+
+    // 旧的文件系统可能管理到了硬盘末尾，交换区只使用其后的部分
+    dword end = sysFileSystem.sb.dataFieldStartSector + sysFileSystem.sb.dataFieldLength;
+    swapFirstSlot = 0;
+    if (end > SWAP_START)
+    {
+        swapFirstSlot = (end - SWAP_START + SECTORS_PER_PAGE - 1) / SECTORS_PER_PAGE;
+    }
+
+    printf("swap: %d pages\n", swapFirstSlot < SWAP_MAX_SLOTS ? SWAP_MAX_SLOTS - swapFirstSlot : 0);
+}
+
+bool isSwappedOut(const dword address)
+{
+    return address < 0xc0000000 && (*toPDE(address) & PTE_PRESENT) && (*toPTE(address) & PTE_SWAPPED);
+}
+
+bool swapIn(const dword address)
+{
+    dword *entry = toPTE(address);
+    dword pte = *entry;
+
+    dword paddr = (dword)allocatePhysicalPage(AddressPoolType::USER);
+    if (!paddr)
+        return false;
+
+    // 读入期间可能被调度走，临时映射只在读一个扇区时持有
+    dword sector = SWAP_START + (pte >> 12) * SECTORS_PER_PAGE;
+    for (dword i = 0; i < SECTORS_PER_PAGE; ++i)
+    {
+        byte *page = (byte *)kmap(paddr);
+        bool ans = Disk::read(sector + i, page + i * SECTOR_SIZE);
+        kunmap(page);
+
+        if (!ans)
+        {
+            // 读不出换出的内容，页仍留在交换区
+            releasePhysicalPage(paddr);
+            return false;
+        }
+    }
+
+    // 恢复换出前的权限，写时复制的标记也保留
+    *entry = paddr | (pte & 0xfff & ~PTE_SWAPPED) | PTE_PRESENT;
+    releaseSwapSlot(pte);
+    ++memoryCounters.swapIns;
+
+    return true;
+}
+
+bool reclaimUserPages()
+{
+    SwapVictim victims[SWAP_CLUSTER];
+    dword amount = 0;
+
+    bool status = _interrupt_status();
+    _disable_interrupt();
+
+    // 每一轮老化所有进程的匿名页，直到选中了页或所有页都老化到0
+    for (dword round = 0; round < SWAP_AGING_ROUNDS && !amount; ++round)
+    {
+        for (ThreadListItem *item = sysProgramManager.allPrograms.front();
+             item && amount < SWAP_CLUSTER; item = sysProgramManager.allPrograms.next(item))
+        {
+            PCB *pcb = (PCB *)((dword)item & 0xfffff000);
+            // 线程没有用户空间，退出的进程已释放页表
+            if (pcb->pageDir && pcb->status != ThreadStatus::DEAD)
+            {
+                ageUserPages(pcb, victims, amount);
+            }
+        }
+    }
+
+    // 写硬盘的时间很长，恢复调用者的中断状态后再写，选中的页和页表被引用着不会释放。
+    // 调用者关着中断时(例如内核在关中断时访问了换出的页)，写入仍然是关中断的
+    _set_interrupt(status);
+    for (dword i = 0; i < amount; ++i)
+    {
+        victims[i].written = writeSwapSlot(victims[i].slot, victims[i].paddr);
+    }
+
+    dword evicted = 0;
+    _disable_interrupt();
+    for (dword i = 0; i < amount; ++i)
+    {
+        if (swapOut(victims[i]))
+        {
+            ++evicted;
+        }
+    }
+    _set_interrupt(status);
+
+    return evicted;
+}
+
+void shareSwapSlot(const dword pte)
+{
+    bool status = _interrupt_status();
+    _disable_interrupt();
+    ++swapSlots[pte >> 12];
+    _set_interrupt(status);
+}
+
+void releaseSwapSlot(const dword pte)
+{
+    dword slot = pte >> 12;
+
+    // 共享交换槽的进程可能同时换入
+    bool status = _interrupt_status();
+    _disable_interrupt();
+
+    --swapSlots[slot];
+    if (!swapSlots[slot])
+    {
+        --swapUsedSlots;
+    }
+
+    _set_interrupt(status);
+}
+
+dword allocateSwapSlot()
+{
+    for (dword i = swapFirstSlot; i < SWAP_MAX_SLOTS; ++i)
+    {
+        if (!swapSlots[i])
+        {
+            swapSlots[i] = 1;
+            ++swapUsedSlots;
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void ageUserPages(PCB *process, SwapVictim *victims, dword &amount)
+{
+    bool current = process == sysProgramManager.running();
+
+    // 其他进程的页表不在当前地址空间中，都通过临时映射访问
+    for (dword i = USER_VADDR_START >> 22; i < 768 && amount < SWAP_CLUSTER; ++i)
+    {
+        if (!(process->pageDir[i] & PTE_PRESENT))
+            continue;
+
+        dword tablePaddr = process->pageDir[i] & 0xfffff000;
+        dword *table = (dword *)kmap(tablePaddr);
+
+        for (dword j = 0; j < 1024 && amount < SWAP_CLUSTER; ++j)
+        {
+            if (!(table[j] & PTE_PRESENT))
+                continue;
+
+            // 多个进程共享的页找不到所有的页表项，文件映射和共享内存的页不换出，
+            // 已被选中正在写入的页也多了一个引用
+            PageFrame *frame = pageFrames + (table[j] >> 12);
+            dword address = (i << 22) | (j << 12);
+            VirtualArea *area = process->userVaddr.find(address);
+            if (frame->refCount != 1 || (area && !(area->flags & VMA_ANONYMOUS)))
+                continue;
+
+            frame->age = (frame->age >> 1) | ((table[j] & PTE_ACCESSED) ? 0x80 : 0);
+            table[j] &= ~PTE_ACCESSED;
+
+            dword slot = -1;
+            if (!frame->age)
+            {
+                slot = allocateSwapSlot();
+            }
+
+            if (slot != (dword)-1)
+            {
+                // 写入期间页和页表都不能被释放，清除脏位以发现写入期间的修改
+                shareFrame(table[j] & 0xfffff000);
+                shareFrame(tablePaddr);
+                table[j] &= ~PTE_DIRTY;
+
+                SwapVictim &victim = victims[amount++];
+                victim.process = process;
+                victim.address = address;
+                victim.table = tablePaddr;
+                victim.paddr = table[j] & 0xfffff000;
+                victim.slot = slot;
+                victim.written = false;
+            }
+
+            // 切换到其他进程时会重新加载cr3，只有当前进程的TLB项需要失效
+            if (current)
+            {
+                invalidatePage(address);
+            }
+        }
+
+        kunmap(table);
+    }
+}
+
+bool writeSwapSlot(const dword slot, const dword paddr)
+{
+    dword sector = SWAP_START + slot * SECTORS_PER_PAGE;
+    bool ans = true;
+
+    // 写入期间可能被调度走，临时映射只在写一个扇区时持有
+    for (dword i = 0; i < SECTORS_PER_PAGE && ans; ++i)
+    {
+        byte *page = (byte *)kmap(paddr);
+        ans = Disk::write(sector + i, page + i * SECTOR_SIZE);
+        kunmap(page);
+    }
+
+    return ans;
+}
+
+bool swapOut(const SwapVictim &victim)
+{
+    PageFrame *frame = pageFrames + victim.paddr / PAGE_SIZE;
+    bool evicted = false;
+
+    // 页和页表都只剩所属进程和选中时的引用，说明页仍然映射在原来的页表项上。
+    // 进程退出或解除映射后引用减少，fork后页的引用增加，这些页都不换出
+    if (victim.written && frame->refCount == 2 && pageFrames[victim.table / PAGE_SIZE].refCount == 2)
+    {
+        dword *table = (dword *)kmap(victim.table);
+        dword *entry = table + ((victim.address >> 12) & 0x3ff);
+
+        // 写入期间被修改过的页没有完整写入交换区，仍然常驻
+        if ((*entry & (0xfffff000 | PTE_PRESENT | PTE_DIRTY)) == (victim.paddr | PTE_PRESENT))
+        {
+            *entry = (victim.slot << 12) | (*entry & 0xfff & ~(PTE_PRESENT | PTE_ACCESSED)) | PTE_SWAPPED;
+            if (victim.process == sysProgramManager.running())
+            {
+                invalidatePage(victim.address);
+            }
+
+            --frame->refCount;
+            ++memoryCounters.swapOuts;
+            evicted = true;
+        }
+
+        kunmap(table);
+    }
+
+    if (!evicted)
+    {
+        releaseSwapSlot(victim.slot << 12);
+    }
+
+    // 放弃选中时持有的引用，换出的页在这里被释放
+    releasePhysicalPage(victim.paddr);
+    releasePhysicalPage(victim.table);
+
+    return evicted;
+}
@@ -0,0 +1,58 @@
+#ifndef SWAP_H
+#define SWAP_H
+
+#include "../configure/type.h"
+#include "../configure/os_configure.h"
+
+// 每页占用的扇区数
+#define SECTORS_PER_PAGE (PAGE_SIZE / SECTOR_SIZE)
+// 交换槽数，每个槽存放一页
+#define SWAP_MAX_SLOTS (SWAP_SECTOR_AMOUNT / SECTORS_PER_PAGE)
+// 每次回收最多换出的页数
+#define SWAP_CLUSTER 8
+// 老化的最多轮数，年龄是8位的，没有再被访问的页最多8轮后年龄为0
+#define SWAP_AGING_ROUNDS 9
+
+struct PCB;
+
+// 选中换出的页，写入交换区期间页仍然映射，页和页表都多持有一个引用
+struct SwapVictim
+{
+    PCB *process;  // 页所属的进程
+    dword address; // 页的虚拟地址
+    dword table;   // 页表的物理地址
+    dword paddr;   // 页的物理地址
+    dword slot;    // 分配的交换槽
+    bool written;  // 是否已完整写入交换区
+};
+
+// 每个交换槽的引用计数，fork后父子进程的页表项指向同一个槽
+word swapSlots[SWAP_MAX_SLOTS];
+// 第一个可用的交换槽，已建立的文件系统可能占用了交换区的开头
+dword swapFirstSlot;
+// 正在使用的交换槽数
+dword swapUsedSlots;
+
+// 初始化交换区，需要在文件系统初始化之后调用
+void initSwap();
+// 当前进程的address是否已被换出
+bool isSwappedOut(const dword address);
+// 将当前进程已被换出的页address读回内存
+bool swapIn(const dword address);
+// 用户物理页不足时，按年龄换出若干个匿名页，返回是否有物理页被释放
+bool reclaimUserPages();
+// 页表项pte指向的交换槽多了一个共享者
+void shareSwapSlot(const dword pte);
+// 释放页表项pte指向的交换槽
+void releaseSwapSlot(const dword pte);
+
+// 分配一个交换槽，若没有则返回-1
+static dword allocateSwapSlot();
+// 对process的匿名页做一轮老化，年龄为0的页被选中换出，放入victims，amount为已选中的页数
+static void ageUserPages(PCB *process, SwapVictim *victims, dword &amount);
+// 将物理页paddr写入交换槽slot
+static bool writeSwapSlot(const dword slot, const dword paddr);
+// 写入交换区后，页仍未被修改和共享时释放物理页，页表项改为指向交换槽
+static bool swapOut(const SwapVictim &victim);
+
+#endif
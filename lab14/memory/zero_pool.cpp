@@ -0,0 +1,115 @@
+#include "zero_pool.h"
+#include "memory.h"
+#include "../clib/cstdlib.h"
+#include "../kernel/interrupt.h"
+#include "../program/program_manager.h"
+
+ZeroPagePool::ZeroPagePool()
+{
+    initialize(nullptr);
+}
+
+void ZeroPagePool::initialize(BuddyPool *pool)
+{
+    this->pool = pool;
+    head = BUDDY_NULL;
+    count = 0;
+}
+
+dword ZeroPagePool::allocate()
+{
+    bool status = _interrupt_status();
+    _disable_interrupt();
+
+    dword paddr = -1;
+    if (head != BUDDY_NULL)
+    {
+        paddr = head * PAGE_SIZE;
+        head = pageFrames[head].next;
+        --count;
+    }
+
+    if (isLow())
+    {
+        wakeZeroPageWorker();
+    }
+
+    _set_interrupt(status);
+    return paddr;
+}
+
+bool ZeroPagePool::fill()
+{
+    while (count < ZERO_POOL_SIZE)
+    {
+        dword paddr = pool->allocate(1);
+        if (paddr == (dword)-1)
+            return false;
+
+        clearPhysicalPage(paddr);
+        push(paddr);
+    }
+
+    return true;
+}
+
+bool ZeroPagePool::isLow()
+{
+    return count < ZERO_POOL_LOW;
+}
+
+void ZeroPagePool::push(const dword paddr)
+{
+    bool status = _interrupt_status();
+    _disable_interrupt();
+
+    pageFrames[paddr / PAGE_SIZE].next = head;
+    head = paddr / PAGE_SIZE;
+    ++count;
+
+    _set_interrupt(status);
+}
+
+void initZeroPagePools()
+{
+    // 全局变量不调用构造函数
+    kernelZeroPool.initialize(&kernelPool);
+    userZeroPool.initialize(&userPool);
+    zeroPageWorker = nullptr;
+}
+
+void clearPhysicalPage(const dword paddr)
+{
+    // 临时映射的槽只属于当前线程，清零时可以被打断
+    void *window = kmap(paddr);
+    clearPage(window);
+    kunmap(window);
+}
+
+void wakeZeroPageWorker()
+{
+    if (zeroPageWorker && zeroPageWorker->status == ThreadStatus::BLOCKED)
+    {
+        sysProgramManager.wakeUp(zeroPageWorker);
+    }
+}
+
+void zeroPageThread(void *arg)
+{
+    zeroPageWorker = sysProgramManager.running();
+
+    while (true)
+    {
+        // 两个池都要补充
+        bool enough = kernelZeroPool.fill();
+        enough = userZeroPool.fill() && enough;
+
+        // 补充期间又被取走了页则继续补充，没有空闲页时等待下一次唤醒
+        _disable_interrupt();
+        if (!enough || (!kernelZeroPool.isLow() && !userZeroPool.isLow()))
+        {
+            sysProgramManager.block();
+        }
+        _enable_interrupt();
+    }
+}
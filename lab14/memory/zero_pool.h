@@ -0,0 +1,52 @@
+#ifndef ZERO_POOL_H
+#define ZERO_POOL_H
+
+#include "../configure/type.h"
+#include "../configure/os_configure.h"
+#include "buddy.h"
+
+// 每个预清零页池补充到的页数
+#define ZERO_POOL_SIZE 32
+// 预清零页少于此数时唤醒清零线程
+#define ZERO_POOL_LOW 16
+
+struct PCB;
+
+// 预先清零的物理页池，页从伙伴系统中分配，通过页框描述表的next串成链表
+class ZeroPagePool
+{
+public:
+    BuddyPool *pool; // 页的来源
+    dword head;      // 链表头的物理页号
+    dword count;     // 池中的页数
+
+public:
+    ZeroPagePool();
+    // 初始化，pool=页的来源
+    void initialize(BuddyPool *pool);
+    // 取出一个已清零的页，返回物理地址，若没有则返回-1
+    dword allocate();
+    // 从伙伴系统分配页，清零后补充到ZERO_POOL_SIZE个，伙伴系统没有空闲页时返回false
+    bool fill();
+    // 是否需要补充
+    bool isLow();
+
+private:
+    // 将已清零的页放入池中
+    void push(const dword paddr);
+};
+
+ZeroPagePool kernelZeroPool, userZeroPool;
+// 清零线程的PCB，线程启动前为nullptr
+PCB *zeroPageWorker;
+
+// 初始化预清零页池
+void initZeroPagePools();
+// 通过临时映射将物理页paddr清零
+void clearPhysicalPage(const dword paddr);
+// 唤醒清零线程，需要在关中断的情况下调用
+void wakeZeroPageWorker();
+// 清零线程，预清零页不足时被唤醒，补充后阻塞
+void zeroPageThread(void *arg);
+
+#endif
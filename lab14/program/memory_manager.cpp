@@ -1,113 +1,232 @@
 #include "program_manager.h"
+#include "../clib/cstdlib.h"
+#include "../kernel/interrupt.h"
 
 MemoryManager::MemoryManager()
 {
     initialize();
 }
 
-void MemoryManager::initialize()
+const dword MemoryManager::arenaSize[MemoryManager::MEM_BLOCK_TYPES] = {
+    16, 20, 24, 28,
+    32, 40, 48, 56,
+    64, 80, 96, 112,
+    128, 160, 192, 224,
+    256, 320, 384, 448,
+    512, 640, 768, 896,
+    1024, 1280, 1536, 1792};
+
+void MemoryManager::initialize(const AddressPoolType type)
 {
-    dword size = minSize;
     for (int i = 0; i < MEM_BLOCK_TYPES; ++i)
     {
-        arenas[i] = nullptr;
-        arenaSize[i] = size;
-        size = size << 1;
+        partialArenas[i] = nullptr;
+        fullArenas[i] = nullptr;
     }
-    mutex.initialize(1); // 内存分配和释放时实现互斥
+    emptyArenas = nullptr;
+    emptyArenaCount = 0;
+    failures = 0;
+    this->type = type;
 }
 
-void *MemoryManager::allocate(dword size)
+dword MemoryManager::sizeClass(dword size)
 {
-    dword index = 0;
-    while (index < MEM_BLOCK_TYPES && arenaSize[index] < size)
-        ++index;
+    // 二分查找第一个不小于size的类型
+    dword low = 0, high = MEM_BLOCK_TYPES, mid;
 
-    PCB *pcb = sysProgramManager.running();
-    AddressPoolType poolType = (pcb->pageDir) ? AddressPoolType::USER : AddressPoolType::KERNEL;
+    while (low < high)
+    {
+        mid = (low + high) / 2;
+        if (arenaSize[mid] < size)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+dword MemoryManager::arenaBlocks(dword index)
+{
+    return (PAGE_SIZE - sizeof(Arena)) / arenaSize[index];
+}
+
+void *MemoryManager::allocate(dword size)
+{
+    dword index = sizeClass(size);
     void *ans = nullptr;
 
+    bool status = _interrupt_status();
+    _disable_interrupt();
+
     if (index == MEM_BLOCK_TYPES)
     {
-        // 上取整
+        // 上取整，size过大时直接失败
         dword pageAmount = (size + sizeof(Arena) + PAGE_SIZE - 1) / PAGE_SIZE;
 
-        mutex.P();
-        ans = allocatePages(poolType, pageAmount);
-        mutex.V();
-
-        if (ans)
+        Arena *arena = size <= MAX_ALLOCATE_SIZE ? (Arena *)reservePages(type, pageAmount) : nullptr;
+        if (arena)
         {
-            Arena *arena = (Arena *)ans;
             arena->type = ArenaType::ARENA_MORE;
             arena->counter = pageAmount;
+            // 返回的地址要越过Arena的描述信息
+            ans = (void *)((dword)arena + sizeof(Arena));
         }
     }
-    else
+    else if (partialArenas[index] || getNewArena(index))
     {
-        //printf("---MemoryManager::allocate----\n");
-        if (arenas[index] == nullptr)
+        // 从第一个还有空闲块的Arena中取出一个内存块
+        Arena *arena = partialArenas[index];
+        MemoryBlockListItem *item = arena->freeBlocks;
+        arena->freeBlocks = item->next;
+        --(arena->counter);
+
+        if (arena->counter == 0)
         {
-            if (!getNewArena(poolType, index))
-                return nullptr;
+            unlinkArena(&partialArenas[index], arena);
+            linkArena(&fullArenas[index], arena);
         }
 
-        // 每次取出内存块链表中的第一个内存块
-        ans = arenas[index];
-        arenas[index] = ((MemoryBlockListItem *)ans)->next;
+        ans = item;
+    }
+
+    if (!ans)
+    {
+        ++failures;
+    }
+
+    _set_interrupt(status);
+    return ans;
+}
+
+void *MemoryManager::reallocate(void *address, dword size)
+{
+    if (!address)
+        return allocate(size);
+
+    if (!size)
+    {
+        release(address);
+        return nullptr;
+    }
+
+    if (size > MAX_ALLOCATE_SIZE)
+        return nullptr;
 
-        if (arenas[index])
+    Arena *arena = (Arena *)((dword)address & 0xfffff000);
+    dword capacity;
+    bool resized = false;
+
+    bool status = _interrupt_status();
+    _disable_interrupt();
+
+    if (arena->type == ARENA_MORE)
+    {
+        dword pageAmount = (size + sizeof(Arena) + PAGE_SIZE - 1) / PAGE_SIZE;
+        dword end = (dword)arena + arena->counter * PAGE_SIZE;
+
+        if (pageAmount <= arena->counter)
+        {
+            // 缩小时归还尾部的页
+            if (pageAmount < arena->counter)
+            {
+                releasePage(type, (dword)arena + pageAmount * PAGE_SIZE, arena->counter - pageAmount);
+                arena->counter = pageAmount;
+            }
+            resized = true;
+        }
+        else if (reservePagesAt(type, end, pageAmount - arena->counter))
         {
-            (arenas[index])->previous = nullptr;
+            // 紧随其后的虚拟页空闲时原地扩展
+            arena->counter = pageAmount;
+            resized = true;
         }
 
-        Arena *arena = (Arena *)((dword)ans & 0xfffff000);
-        --(arena->counter);
-        //printf("---MemoryManager::allocate----\n");
+        capacity = arena->counter * PAGE_SIZE - sizeof(Arena);
+    }
+    else
+    {
+        // 内存块中还有足够的空间
+        capacity = arenaSize[arena->type];
+        resized = size <= capacity;
     }
 
+    _set_interrupt(status);
+
+    if (resized)
+        return address;
+
+    void *ans = allocate(size);
+    if (!ans)
+        return nullptr;
+
+    memcpy(address, ans, capacity < size ? capacity : size);
+    release(address);
+
+    return ans;
+}
+
+void *MemoryManager::allocateZeroed(dword size)
+{
+    void *ans = allocate(size);
+    if (!ans)
+        return nullptr;
+
+    // 用户空间按页分配的内存刚刚保留，首次访问时映射的就是清零的页
+    Arena *arena = (Arena *)((dword)ans & 0xfffff000);
+    if (arena->type == ARENA_MORE && type == AddressPoolType::USER)
+        return ans;
+
+    memset((byte *)ans, 0, size);
     return ans;
 }
 
-bool MemoryManager::getNewArena(AddressPoolType type, dword index)
+bool MemoryManager::getNewArena(dword index)
 {
-    mutex.P();
-    void *ptr = allocatePages(type, 1);
-    mutex.V();
+    Arena *arena = emptyArenas;
 
-    if (ptr == nullptr)
-        return false;
+    // 优先复用缓存的空Arena
+    if (arena)
+    {
+        unlinkArena(&emptyArenas, arena);
+        --emptyArenaCount;
+    }
+    else
+    {
+        arena = (Arena *)reservePages(type, 1);
+        if (arena == nullptr)
+            return false;
+    }
+
+    formatArena(arena, index);
+    linkArena(&partialArenas[index], arena);
+    return true;
+}
 
+void MemoryManager::formatArena(Arena *arena, dword index)
+{
     // 内存块的数量
-    dword times = (PAGE_SIZE - sizeof(Arena)) / arenaSize[index];
+    dword times = arenaBlocks(index);
     // 内存块的起始地址
-    dword address = (dword)ptr + sizeof(Arena);
+    dword address = (dword)arena + sizeof(Arena);
 
-    // 记录下内存块的数据
-    Arena *arena = (Arena *)ptr;
     arena->type = (ArenaType)index;
     arena->counter = times;
-    // printf("---MemoryManager::getNewArena: type: %d, arena->counter: %d\n", index, arena->counter);
-
-    MemoryBlockListItem *prevPtr = (MemoryBlockListItem *)address;
-    MemoryBlockListItem *curPtr = nullptr;
-    arenas[index] = prevPtr;
-    prevPtr->previous = nullptr;
-    prevPtr->next = nullptr;
-    --times;
+    arena->freeBlocks = (MemoryBlockListItem *)address;
 
-    while (times)
+    MemoryBlockListItem *item;
+    while (times > 1)
     {
+        item = (MemoryBlockListItem *)address;
         address += arenaSize[index];
-        curPtr = (MemoryBlockListItem *)address;
-        prevPtr->next = curPtr;
-        curPtr->previous = prevPtr;
-        curPtr->next = nullptr;
-        prevPtr = curPtr;
+        item->next = (MemoryBlockListItem *)address;
         --times;
     }
-
-    return true;
+    ((MemoryBlockListItem *)address)->next = nullptr;
 }
 
 void MemoryManager::release(void *address)
@@ -116,67 +235,114 @@ void MemoryManager::release(void *address)
     // 其中划分的内存块的高20位也必定与其所在的Arena首地址相同
     Arena *arena = (Arena *)((dword)address & 0xfffff000);
 
+    bool status = _interrupt_status();
+    _disable_interrupt();
+
     if (arena->type == ARENA_MORE)
     {
-        dword address = (dword)arena;
-
-        mutex.P();
-        releasePage(address, arena->counter);
-        mutex.V();
+        releasePage(type, (dword)arena, arena->counter);
     }
     else
     {
-        MemoryBlockListItem *itemPtr = (MemoryBlockListItem *)address;
-        itemPtr->next = arenas[arena->type];
-        itemPtr->previous = nullptr;
-
-        if (itemPtr->next)
-        {
-            itemPtr->next->previous = itemPtr;
-        }
+        dword index = arena->type;
 
-        arenas[arena->type] = itemPtr;
+        MemoryBlockListItem *item = (MemoryBlockListItem *)address;
+        item->next = arena->freeBlocks;
+        arena->freeBlocks = item;
         ++(arena->counter);
 
-        // 若整个Arena被归还，则清空分配给Arena的页
-        dword amount = (PAGE_SIZE - sizeof(Arena)) / arenaSize[arena->type];
-        // printf("---MemoryManager::release---: arena->counter: %d, amount: %d\n", arena->counter, amount);
+        // Arena由全部分配变为部分分配
+        if (arena->counter == 1)
+        {
+            unlinkArena(&fullArenas[index], arena);
+            linkArena(&partialArenas[index], arena);
+        }
 
-        if (arena->counter == amount)
+        // 整个Arena被归还，放入空Arena缓存，缓存满了才归还页
+        if (arena->counter == arenaBlocks(index))
         {
-            // 将属于Arena的内存块从链上删除
-            while (itemPtr)
+            unlinkArena(&partialArenas[index], arena);
+
+            if (emptyArenaCount < MAX_EMPTY_ARENAS)
+            {
+                linkArena(&emptyArenas, arena);
+                ++emptyArenaCount;
+            }
+            else
             {
-                if ((dword)arena != ((dword)itemPtr & 0xfffff000))
-                {
-                    itemPtr = itemPtr->next;
-                    continue;
-                }
-
-                if (itemPtr->previous == nullptr) // 链表中的第一个节点
-                {
-                    arenas[arena->type] = itemPtr->next;
-                    if (itemPtr->next)
-                    {
-                        itemPtr->next->previous = nullptr;
-                    }
-                }
-                else
-                {
-                    itemPtr->previous->next = itemPtr->next;
-                }
-
-                if (itemPtr->next)
-                {
-                    itemPtr->next->previous = itemPtr->previous;
-                }
-
-                itemPtr = itemPtr->next;
+                releasePage(type, (dword)arena, 1);
             }
+        }
+    }
+
+    _set_interrupt(status);
+}
+
+dword MemoryManager::statistics(ArenaStats *stats)
+{
+    bool status = _interrupt_status();
+    _disable_interrupt();
+
+    for (dword i = 0; i < MEM_BLOCK_TYPES; ++i)
+    {
+        stats[i].size = arenaSize[i];
+        stats[i].blocks = 0;
+        stats[i].arenas = 0;
 
-            mutex.P();
-            releasePage((dword)address, 1);
-            mutex.V();
+        for (Arena *arena = partialArenas[i]; arena; arena = arena->next)
+        {
+            stats[i].blocks += arenaBlocks(i) - arena->counter;
+            ++stats[i].arenas;
+        }
+
+        for (Arena *arena = fullArenas[i]; arena; arena = arena->next)
+        {
+            stats[i].blocks += arenaBlocks(i);
+            ++stats[i].arenas;
         }
     }
-}
\ No newline at end of file
+
+    _set_interrupt(status);
+    return emptyArenaCount;
+}
+
+void *kmalloc(dword size)
+{
+    return sysMemoryManager.allocate(size);
+}
+
+void kfree(void *address)
+{
+    sysMemoryManager.release(address);
+}
+
+void MemoryManager::unlinkArena(Arena **list, Arena *arena)
+{
+    if (arena->previous)
+    {
+        arena->previous->next = arena->next;
+    }
+    else
+    {
+        *list = arena->next;
+    }
+
+    if (arena->next)
+    {
+        arena->next->previous = arena->previous;
+    }
+
+    arena->previous = arena->next = nullptr;
+}
+
+void MemoryManager::linkArena(Arena **list, Arena *arena)
+{
+    arena->previous = nullptr;
+    arena->next = *list;
+
+    if (*list)
+    {
+        (*list)->previous = arena;
+    }
+    *list = arena;
+}
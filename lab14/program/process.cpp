@@ -28,7 +28,8 @@ void startProcess(void *filename)
     interruptStack->eip = (dword)filename;
     interruptStack->cs = 0x33;                                // 用户模式平坦模式
     interruptStack->eflags = (3 << 12) | (1 << 9) | (1 << 1); // IOPL, IF, MBS
-    interruptStack->esp = (dword)specifyPaddrForVaddr(AddressPoolType::USER, USER_STACK_VADDR) + PAGE_SIZE;
+    // 栈页在第一次访问时由页错误处理函数分配
+    interruptStack->esp = USER_STACK_VADDR + PAGE_SIZE;
     interruptStack->esp -= 3 * sizeof(dword);
     // 设置返回process地址
     ((dword *)(interruptStack->esp))[0] = (dword)exit;
@@ -48,6 +49,11 @@ void ProgramManager::activatePageDir(PCB *program)
         paddr = vaddr2paddr((dword)program->pageDir);
     }
 
+    // 内核线程之间切换时地址空间不变，不重新加载cr3，TLB得以保留
+    if (paddr == activePageDir)
+        return;
+
+    activePageDir = paddr;
     sys_update_cr3(paddr);
 }
 
@@ -65,15 +71,13 @@ void ProgramManager::activatePageTab(PCB *program)
 // 创建用户进程的页目录表
 dword *ProgramManager::createPageDir()
 {
-    dword *vaddr = (dword *)allocatePages(AddressPoolType::KERNEL, 1);
+    dword *vaddr = (dword *)allocatePages(AddressPoolType::KERNEL, 1, true);
     if (!vaddr)
     {
         //printf("can not create page from kernel\n");
         return nullptr;
     }
 
-    memset((byte *)vaddr, 0, PAGE_SIZE);
-
     // 复制内核目录项到虚拟地址的高1GB
     dword *src = (dword *)(0xfffff000 + 0x300 * 4);
     dword *dst = (dword *)((dword)vaddr + 0x300 * 4);
@@ -90,15 +94,10 @@ dword *ProgramManager::createPageDir()
 // 创建用户虚拟地址池
 void ProgramManager::createUserVaddrPool(PCB *pcb)
 {
-    dword sourcesCount = (0xc0000000 - USER_VADDR_START) / PAGE_SIZE;
-    dword length = (sourcesCount + 8 - 1) / 8;
-    // 计算位图所占的页数
-    dword pagesCount = (length + PAGE_SIZE - 1) / PAGE_SIZE;
-
-    void *start = allocatePages(AddressPoolType::KERNEL, pagesCount);
-    memset((byte *)start, 0, PAGE_SIZE);
-    (pcb->userVaddr).setResources((byte *)start, sourcesCount);
-    (pcb->userVaddr).setStartAddress(USER_VADDR_START);
+    // 区域表占用一个内核页，栈所在的区域不归区域表管理
+    void *start = allocatePages(AddressPoolType::KERNEL, 1);
+    (pcb->userVaddr).initialize((VirtualArea *)start, PAGE_SIZE / sizeof(VirtualArea),
+                                USER_VADDR_START, USER_STACK_LIMIT);
 }
 
 // 创建用户进程
@@ -117,7 +116,7 @@ dword ProgramManager::executeProcess(void *filename, const char *name, dword pri
     threadStack->eip = (dword)startProcess;
     threadStack->arg = filename;
 
-    process->memoryManager.initialize();
+    process->memoryManager.initialize(AddressPoolType::USER);
 
     // 实现和文件系统相关内容
 
@@ -134,34 +133,21 @@ dword ProgramManager::executeProcess(void *filename, const char *name, dword pri
     bool interruptStatus = _interrupt_status();
     _disable_interrupt();
     allPrograms.push_back(&(process->tagInAllList));
-    readyPrograms.push_back(&(process->tagInGeneralList));
+    pushReady(process);
+    // 第一个用户进程作为init进程
+    if (!initProcess)
+    {
+        initProcess = process;
+    }
     _set_interrupt(interruptStatus);
 
     return process->pid;
 }
 
-PCB *ProgramManager::findChildProcess(dword parentPid)
+PCB *ProgramManager::findChildProcess(PCB *parent)
 {
-    ThreadListItem *item = allPrograms.head.next;
-    PCB *child, *ans;
-
-    ans = nullptr;
-
-    bool status = _interrupt_status();
-    _disable_interrupt();
-    while (item)
-    {
-        child = threadListItem2PCB(item);
-        if (child->parentPid == parentPid)
-        {
-            ans = child;
-            break;
-        }
-        item = item->next;
-    }
-    _set_interrupt(status);
-
-    return ans;
+    ThreadListItem *item = parent->children.front();
+    return item ? threadListItem2PCB(item) : nullptr;
 }
 
 dword ProgramManager::fork()
@@ -181,11 +167,14 @@ dword ProgramManager::fork()
         bool interruptStatus = _interrupt_status();
         _disable_interrupt();
         sysProgramManager.allPrograms.push_front(&(child->tagInAllList));
-        sysProgramManager.readyPrograms.push_front(&(child->tagInGeneralList));
+        parent->children.push_back(&(child->tagInChildList));
+        sysProgramManager.pushReady(child, true);
         _set_interrupt(interruptStatus);
        // printf("child pid: %d\n", child->pid);
         return child->pid;
     } else {
+        // copyProcess已归还子进程的其他资源
+        releaseKernelPage((dword)child, 1);
         return -1;
     }
 }
@@ -199,7 +188,7 @@ bool ProgramManager::copyProcess(PCB *parent, PCB *child)
      ****************************************/
 
     // 复制父进程0级栈
-    memcpy(parent, child, PAGE_SIZE);
+    copyPage(parent, child);
     // 构造子进程0级栈
     ThreadInterruptStack *interruptStack = (ThreadInterruptStack *)((dword)child + PAGE_SIZE - sizeof(ThreadInterruptStack));
     interruptStack->eax = 0;
@@ -224,8 +213,14 @@ bool ProgramManager::copyProcess(PCB *parent, PCB *child)
     child->ticksPassedBy = 0;
 
     child->pid = sysProgramManager.allocatePid();
+    if (child->pid == (dword)-1)
+        return false;
     //printf("allocate pid: %d\n", child->pid);
     child->parentPid = parent->pid;
+    // PCB是从父进程复制来的，子进程自己的链表要重新初始化
+    child->parent = parent;
+    child->children.initialize();
+    child->childWaiters.initialize();
 
     // 复制进程页目录表，遵循页目录表定义规则。
     // 0~767用户页目录项，768~1022内核页目录项，1023页目录表物理地址
@@ -233,6 +228,7 @@ bool ProgramManager::copyProcess(PCB *parent, PCB *child)
     if (!child->pageDir)
     {
         // 释放前面分配的内容
+        sysProgramManager.releasePid(child->pid);
         return false;
     }
 
@@ -240,74 +236,92 @@ bool ProgramManager::copyProcess(PCB *parent, PCB *child)
 
     // 复制虚拟地址池
     sysProgramManager.createUserVaddrPool(child);
-    dword bitmapLength = parent->userVaddr.resources.length;
-    dword bitmapBytes = stdmath::roundup(bitmapLength, 8);
-    memcpy(parent->userVaddr.resources.bitmap, child->userVaddr.resources.bitmap, bitmapBytes);
+    if (!child->userVaddr.areas)
+    {
+        releaseKernelPage((dword)child->pageDir, 1);
+        sysProgramManager.releasePid(child->pid);
+        return false;
+    }
+    child->userVaddr.copy(parent->userVaddr);
 
     /****************************************
-     * 用户地址空间操作(实际上是复制页表和物理页)
+     * 用户地址空间操作(只复制页表，物理页写时复制)
      ****************************************/
 
-    // 复制用户空间页表
-    byte *buffer = (byte *)allocatePages(AddressPoolType::KERNEL, 1);
-    dword childPageDirPaddr = vaddr2paddr((dword)child->pageDir);
-    dword parentPageDirPaddr = vaddr2paddr((dword)parent->pageDir);
-
-    if (!buffer)
+    // 先为子进程分配页表，物理页不足时会换出页并写硬盘，不能在关中断时进行
+    for (dword i = 0; i < 768; ++i)
     {
-        // 释放前面分配的内容
-        return false;
+        if (!(parent->pageDir[i] & 0x1))
+            continue;
+
+        dword paddr = (dword)allocatePhysicalPage(AddressPoolType::USER);
+        if (!paddr)
+        {
+            // 释放前面分配的页表，之后的页目录项仍是父进程的页表，不能释放
+            while (i--)
+            {
+                if (parent->pageDir[i] & 0x1)
+                {
+                    releasePhysicalPage(child->pageDir[i] & 0xfffff000);
+                }
+            }
+            releaseKernelPage((dword)child->userVaddr.areas, 1);
+            releaseKernelPage((dword)child->pageDir, 1);
+            sysProgramManager.releasePid(child->pid);
+            return false;
+        }
+        child->pageDir[i] = (child->pageDir[i] & 0x00000fff) | paddr;
     }
 
+    // 以下的过程不会失败，共享内存段、文件映射的引用和父进程的写时复制标记都在此之后设置，
+    // 失败时不需要回退
+    inheritSharedSegments(child);
+    shareFileMappings(child);
+
+    // 修改页表项和引用计数的过程不能被其他进程打断
+    bool interruptStatus = _interrupt_status();
+    _disable_interrupt();
+
     for (dword i = 0; i < 768; ++i)
     {
         // 页表存在
         if (parent->pageDir[i] & 0x1)
         {
-            // 复制页目录项对应的页表到子进程
-
             // 计算页表的虚拟地址
             dword *pageTableVaddr = (dword *)(0xffc00000 + (i << 12));
+            dword paddr = child->pageDir[i] & 0xfffff000;
 
-            memcpy(pageTableVaddr, buffer, PAGE_SIZE);
-            dword paddr = (dword)allocatePhysicalPage(AddressPoolType::USER);
-            if (!paddr)
-            {
-                // 释放前面分配的资源
-                return false;
-            }
-
-            sys_update_cr3(childPageDirPaddr); // 下面根据的就是子进程的页目录表进行寻址
-            child->pageDir[i] = (child->pageDir[i] & 0x00000fff) | paddr;
-            memcpy(buffer, pageTableVaddr, PAGE_SIZE);
-            sys_update_cr3(parentPageDirPaddr);
-
-            void *pageVaddr;
-
-            // 复制物理页
+            // 父子进程共享物理页，可写的页改为只读并标记为写时复制，共享内存和文件映射的页保持可写，
+            // 否则私有副本带着脏位，父子进程都会把各自的副本写回文件
             for (int j = 0; j < 1024; ++j)
             {
-                if (pageTableVaddr[j] & 0x1)
+                if (pageTableVaddr[j] & PTE_PRESENT)
                 {
-                    paddr = (dword)allocatePhysicalPage(AddressPoolType::USER);
-                    if (!paddr)
+                    shareFrame(pageTableVaddr[j] & 0xfffff000);
+                    if ((pageTableVaddr[j] & PTE_WRITE) && !isSharedPage(parent, (i << 22) | (j << 12)))
                     {
-                        // 释放前面分配的资源
-                        return false;
+                        pageTableVaddr[j] = (pageTableVaddr[j] & ~PTE_WRITE) | PTE_COW;
                     }
-                    pageVaddr = (void *)((i << 22) + (j << 12));
-                    memcpy(pageVaddr, buffer, PAGE_SIZE);
-
-                    sys_update_cr3(childPageDirPaddr);
-                    pageTableVaddr[j] = (pageTableVaddr[j] & 0x00000fff) | paddr;
-                    memcpy(buffer, pageVaddr, PAGE_SIZE);
-                    sys_update_cr3(parentPageDirPaddr);
+                }
+                else if (pageTableVaddr[j] & PTE_SWAPPED)
+                {
+                    // 换出的页由父子进程共享交换槽，换入时各自得到私有的副本
+                    shareSwapSlot(pageTableVaddr[j]);
                 }
             }
+
+            // 子进程的页表和父进程的相同，通过临时映射写入子进程的页表
+            void *window = kmap(paddr);
+            copyPage(pageTableVaddr, window);
+            kunmap(window);
+            ++memoryCounters.forkPageTables;
         }
     }
 
-    // 归还从内核分配的页表
-    releaseKernelPage((dword)buffer, 1);
+    // 父进程的页表项变为只读，需要刷新TLB
+    sys_flush_tlb();
+    ++memoryCounters.forks;
+    _set_interrupt(interruptStatus);
+
     return true;
 }
@@ -2,11 +2,26 @@
 #define PROGRAM_CONFIGURE
 
 // 最大线程/进程数
-#define MAX_PROGRAM_AMOUNT 16
+#define MAX_PROGRAM_AMOUNT 512
 // 最大线程名
 #define MAX_PROGRAM_NAME 16
+// 优先级的级数，数值越大优先级越高，优先级同时是线程时间片的长度
+#define PRIORITY_LEVELS 32
+// 可用的最低和最高优先级，0级的时间片为0，不使用
+#define MIN_PRIORITY 1
+#define MAX_PRIORITY (PRIORITY_LEVELS - 1)
+// 多级反馈队列的级数，第0级最优先
+#define MLFQ_LEVELS 4
+// 第0级的时间片，每降一级时间片加倍
+#define MLFQ_BASE_QUANTUM 2
+// 每隔多少次时钟中断把所有线程提升到第0级，避免低级别的线程饥饿，约5秒
+#define MLFQ_BOOST_PERIOD 100
 // 用户进程栈起始地址
 #define USER_STACK_VADDR (0xc0000000 - 0x1000)
+// 用户栈的最大大小，栈在访问时自动向下增长
+#define USER_STACK_SIZE 0x800000
+// 用户栈能增长到的最低地址
+#define USER_STACK_LIMIT (0xc0000000 - USER_STACK_SIZE)
 // 用户堆虚拟地址起始地址
 #define USER_VADDR_START 0x8048000
 
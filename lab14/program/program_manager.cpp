@@ -11,8 +11,18 @@ void ProgramManager::initialize()
 {
     // 最后线程的跳转由内核完成
     currentRunning = nullptr;
+    // loader设置的内核页目录表
+    activePageDir = 0x100000;
     allPrograms.initialize();
-    readyPrograms.initialize();
+    for (int i = 0; i < PRIORITY_LEVELS; ++i)
+    {
+        readyQueues[i].initialize();
+    }
+    readyBitmap = 0;
+    policy = SchedulePolicy::ROUND_ROBIN;
+    boostTicks = 0;
+    initProcess = nullptr;
+    pids.setBitMap((byte *)pidBitmap, MAX_PROGRAM_AMOUNT);
 }
 
 void sysExit(dword status)
@@ -26,6 +36,7 @@ void sysExit(dword status)
     {
         PCB *thread = sysProgramManager.running();
         sysProgramManager.allPrograms.erase(&(thread->tagInAllList));
+        sysProgramManager.releasePid(thread->pid);
         releaseKernelPage((dword)thread, 1);
         thread->status = ThreadStatus::DEAD;
 
@@ -49,40 +60,24 @@ void ProgramManager::exit(dword status)
 {
     PCB *process = currentRunning;
 
-    // 释放进程用户空间的页表
-
-    dword *page;
-
-    // 0~768的页目录表对应用户空间的页目录表
-    for (dword i = 0; i < 768; ++i)
-    {
-        // 页目录表无对应的页表
-        if (!(process->pageDir[i] & 0x1))
-            continue;
-
-        page = (dword *)(0xffc00000 + (i << 12));
+    // 文件映射的脏页写回文件，之后不再引用映射的文件
+    syncAllFiles();
+    releaseFileMappings(process);
 
-        for (dword j = 0; j < 1024; ++j)
-        {
-            // 页表无对应的物理页
-            if (!(page[j] & 0x1))
-                continue;
-            // 释放物理页
-            releasePhysicalPage(vaddr2paddr((i << 22) + (j << 12)));
-        }
+    // 换出页面时会扫描其他进程的页表，从释放页表到在backToParent中标记为DEAD都不能被打断
+    _disable_interrupt();
 
-        // 释放页表占用的物理页
+    // 断开共享内存段的连接，段的物理页随页表一起释放
+    detachSharedSegments(process);
 
-        // 用户页表并未从虚拟地址池中分配地址
-        releasePhysicalPage(vaddr2paddr((dword)page));
-    }
+    // 按区域表释放用户空间的物理页和页表，耗时和常驻内存成正比
+    releaseUserSpace(process);
 
     // 释放页目录表
     releaseKernelPage((dword)process->pageDir, 1);
 
-    // 释放虚拟地址池占用的内核页表
-    dword temp = stdmath::roundup(process->userVaddr.resources.length, 8 * PAGE_SIZE);
-    releaseKernelPage((dword)process->userVaddr.resources.bitmap, temp);
+    // 释放区域表占用的内核页
+    releaseKernelPage((dword)process->userVaddr.areas, 1);
 
     // 关闭打开的文件
     /*******************************/
@@ -101,73 +96,103 @@ void ProgramManager::backToParent()
     bool status = _interrupt_status();
     _disable_interrupt();
 
-    PCB *parent = findProgramByPid(currentRunning->parentPid);
-    if (!parent)
+    PCB *process = currentRunning;
+    PCB *adopter = (initProcess == process) ? nullptr : initProcess;
+    PCB *child;
+    bool exited = false;
+
+    // 子进程交给init进程收养
+    while (!process->children.empty())
+    {
+        child = threadListItem2PCB(process->children.front());
+        process->children.pop_front();
+
+        if (adopter)
+        {
+            child->parent = adopter;
+            child->parentPid = adopter->pid;
+            adopter->children.push_back(&(child->tagInChildList));
+            exited = exited || child->status == ThreadStatus::DEAD;
+        }
+        else if (child->status == ThreadStatus::DEAD)
+        {
+            // init进程自己退出，已退出的子进程没有进程回收了，直接释放
+            allPrograms.erase(&(child->tagInAllList));
+            releasePid(child->pid);
+            releaseKernelPage((dword)child, 1);
+        }
+        else
+        {
+            child->parent = nullptr;
+            child->parentPid = -1;
+        }
+    }
+
+    if (exited)
     {
-        // 1号进程是init进程
-        currentRunning->parentPid = 1;
+        wakeChildWaiters(adopter);
     }
 
-    currentRunning->status = ThreadStatus::DEAD;
+    process->status = ThreadStatus::DEAD;
+    if (process->parent)
+    {
+        wakeChildWaiters(process->parent);
+    }
     schedule();
 
     _set_interrupt(status);
 }
 
+void ProgramManager::wakeChildWaiters(PCB *process)
+{
+    PCB *waiter;
+
+    while (!process->childWaiters.empty())
+    {
+        waiter = threadListItem2PCB(process->childWaiters.front());
+        process->childWaiters.pop_front();
+        wakeUp(waiter);
+    }
+}
+
 dword ProgramManager::wait(dword *status)
 {
+    PCB *process = currentRunning;
     PCB *child;
     ThreadListItem *item;
-    bool interrupt;
-    dword temp;
-    bool flag;
-
-    while (true)
-    {
-        interrupt = _interrupt_status();
-        _disable_interrupt();
+    dword pid;
 
-        item = allPrograms.head.next;
-        flag = true;
+    bool interrupt = _interrupt_status();
+    _disable_interrupt();
 
-        while (item)
+    while (!process->children.empty())
+    {
+        for (item = process->children.front(); item; item = process->children.next(item))
         {
             child = threadListItem2PCB(item);
-            if (child->parentPid == currentRunning->pid)
+            if (child->status == ThreadStatus::DEAD)
             {
-                flag = false;
-                if (child->status == ThreadStatus::DEAD)
+                if (status)
                 {
-                    if (status)
-                    {
-                        *status = child->returnStatus;
-                    }
-
-                    dword pid = child->pid;
-                    releaseKernelPage((dword)child, 1); // 释放子进程PCB
-                    allPrograms.erase(&(child->tagInAllList));
-                    _set_interrupt(interrupt); // 返回之前需要回退中断状态
-                    //printf("release child %d\n", child->pid);
-                    return pid;
+                    *status = child->returnStatus;
                 }
-            }
-            item = item->next;
-        }
-
-        _set_interrupt(interrupt);
 
-        if (flag)
-        {
-            return -1;
+                pid = child->pid;
+                process->children.erase(&(child->tagInChildList));
+                allPrograms.erase(&(child->tagInAllList));
+                releasePid(pid);
+                releaseKernelPage((dword)child, 1); // 释放子进程PCB
+                _set_interrupt(interrupt); // 返回之前需要回退中断状态
+                return pid;
+            }
         }
 
-        //printf("wait for child process\n");
-        // 阻塞一段时间
-        temp = 0xfffff;
-        while (temp)
-        {
-            //printf("%d\n", temp);
-            --temp;
-        }
+        // 没有已退出的子进程，阻塞到有子进程退出时由backToParent唤醒
+        process->childWaiters.push_back(&(process->tagInGeneralList));
+        block();
+        _disable_interrupt();
     }
-}
\ No newline at end of file
+
+    _set_interrupt(interrupt);
+    return -1;
+}
@@ -5,6 +5,7 @@
 #include "../memory/memory.h"
 #include "threadlist.h"
 #include "../clib/cstdio.h"
+#include "../datastructure/bitmap.h"
 
 extern "C" void copyProcess(PCB *parent, PCB *child, dword entry, dword esp, dword esi, dword edi, dword ebx, dword ebp);
 
@@ -22,11 +23,28 @@ void sysExit(dword status);
 // 从文件名加载进程运行, 用户进程初始化，构建用户进程上下文环境
 void startProcess(void *filename);
 
+// 调度策略
+enum SchedulePolicy
+{
+    // 按优先级选择，同一优先级轮转，时间片等于优先级
+    ROUND_ROBIN,
+    // 多级反馈队列，用完时间片的线程降级，阻塞后被唤醒的线程升级，定期全部提升到第0级
+    MLFQ
+};
+
 class ProgramManager
 {
 public:
     PCB *currentRunning; // 当前执行的线程/进程的PCB
-    ThreadList allPrograms, readyPrograms;
+    dword activePageDir; // cr3中的页目录表物理地址
+    ThreadList allPrograms;
+    ThreadList readyQueues[PRIORITY_LEVELS]; // 每个优先级一个就绪队列，同一优先级内轮转
+    dword readyBitmap;                       // 第i位为1表示优先级i的就绪队列非空
+    SchedulePolicy policy;                   // 调度策略
+    PCB *initProcess;                        // 第一个用户进程，收养孤儿进程
+    BitMap pids;                             // 已分配的pid
+    dword pidBitmap[(MAX_PROGRAM_AMOUNT + 31) / 32]; // pids的存储空间
+    dword boostTicks;                        // 距上次全局提升的时钟中断数
 
 public:
     // 初始化
@@ -37,8 +55,22 @@ public:
     void block();
     // 唤醒线程
     void wakeUp(PCB *program);
+    // 当前线程睡眠ticks次时钟中断，期间不在就绪队列中
+    void sleep(dword ticks);
     // 正在执行的线程/进程的pid
     PCB *running();
+    // 将就绪的线程加入其优先级的就绪队列，front为true时加入队首
+    void pushReady(PCB *program, bool front = false);
+    // 取出优先级最高的就绪线程，若没有则返回nullptr
+    PCB *popReady();
+    // 修改线程的优先级，超出范围时取最近的合法值，就绪的线程移到新优先级的队列
+    void setPriority(PCB *program, int priority);
+    // 切换调度策略，所有线程回到第0级并按新策略重新排队
+    void setSchedulePolicy(SchedulePolicy policy);
+    // 时钟中断时调用，返回当前线程是否需要让出处理器
+    bool tick();
+    // 将最多amount个线程的调度信息写入info，返回写入的个数
+    dword scheduleInfo(ScheduleInfo *info, dword amount);
 
     // 创建线程并运行，返回pid
     dword executeThread(ThreadFunction func, void *arg, const char *name, byte priority);
@@ -58,12 +90,24 @@ public:
      * 线程/进程的函数
      */
 
-    // 找到一个可用的pid
+    // 找到一个可用的pid，若没有则返回-1
     dword allocatePid();
+    // 释放线程/进程的pid
+    void releasePid(dword pid);
     // 创建一个线程的PCB并返回
     PCB *buildThreadPCB(ThreadFunction func, void *arg, const char *name, byte priority);
     // 按pid查找线程
     PCB *findProgramByPid(dword pid);
+    // 就绪线程中的最高优先级，readyBitmap不能为0
+    dword highestReadyPriority();
+    // 线程所在就绪队列的下标，多级反馈队列的第0级对应最高的队列
+    dword readyLevel(PCB *program);
+    // 当前调度策略下线程的时间片
+    dword timeSlice(PCB *program);
+    // 将就绪的线程从就绪队列中删除
+    void eraseReady(PCB *program);
+    // 多级反馈队列中把所有线程提升到第0级
+    void boostAll();
 
     PCB *threadListItem2PCB(ThreadListItem *item);
 
@@ -79,8 +123,8 @@ public:
     // 创建用户虚拟地址池
     void createUserVaddrPool(PCB *pcb);
 
-    // 查找一个子进程
-    PCB *findChildProcess(dword parentPid);
+    // 返回进程的第一个子进程，若没有则返回nullptr
+    PCB *findChildProcess(PCB *parent);
 
     /**
      * fork相关函数
@@ -89,8 +133,10 @@ public:
     /**
      * wait、exit相关函数
      */
-    // 唤醒父进程
+    // 子进程交给init进程收养，唤醒在wait中等待的父进程
     void backToParent();
+    // 唤醒在wait中等待process的子进程退出的线程
+    void wakeChildWaiters(PCB *process);
 
     bool copyProcess(PCB *parent, PCB *child);
 };
@@ -17,23 +17,25 @@ void Semaphore::initialize(byte counter)
 
 void Semaphore::P()
 {
+    bool status = _interrupt_status();
+    _disable_interrupt();
 
-    PCB *cur;
-
+    // V可能在中断处理函数中调用，检查和减少counter都要在关中断时进行，
+    // 否则检查之后到达的V会被错过
     while (!counter)
     {
-        bool status = _interrupt_status();
-        _disable_interrupt();
-
         PCB *cur = sysProgramManager.running();
         waiters.push_back(&(cur->tagInGeneralList));
         cur->status = ThreadStatus::BLOCKED;
 
         _set_interrupt(status); // 调度前需要开中断，否则进程无法被调度
         userScheduleThread();
+        _disable_interrupt();
     }
 
     --counter;
+
+    _set_interrupt(status);
 }
 
 void Semaphore::V()
@@ -0,0 +1,86 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+// 基准测试共用的启动过程，和kernel.cpp相同。
+// 基准测试替换kernel.cpp，包含本文件后只需实现firstThread
+
+#include "../../kernel/oslib.h"
+#include "../../clib/string.h"
+#include "../../clib/utils.h"
+#include "../../kernel/interrupt.h"
+#include "../../clib/cstdio.h"
+#include "../../shell/executable.h"
+#include "../../shell/multiprocess.h"
+#include "../../program/lock.h"
+
+#include "../../memory/memory.cpp"
+#include "../../memory/buddy.cpp"
+#include "../../memory/zero_pool.cpp"
+#include "../../memory/slab.cpp"
+#include "../../memory/shm.cpp"
+#include "../../memory/swap.cpp"
+#include "../../memory/stats.cpp"
+#include "../../program/memory_manager.cpp"
+#include "../../program/thread.cpp"
+#include "../../program/process.cpp"
+#include "../../program/program_manager.cpp"
+#include "../../program/threadlist.cpp"
+#include "../../program/addresspool.cpp"
+#include "../../program/vma.cpp"
+#include "../../program/sync.cpp"
+#include "../../kernel/syscall.cpp"
+#include "../../kernel/timer.cpp"
+#include "../../shell/shell.cpp"
+#include "../../ext2/fs.cpp"
+#include "../../disk/disk_bitmap.cpp"
+#include "../../devices/keyboard.cpp"
+
+void init();
+void firstThread(void *arg);
+
+extern "C" void Kernel();
+
+void Kernel()
+{
+    init();
+
+    dword pid = sysProgramManager.executeThread(firstThread, nullptr, "first thread", 2);
+    PCB *thread = sysProgramManager.popReady();
+    thread->status = ThreadStatus::RUNNING;
+    sysProgramManager.currentRunning = thread;
+
+    _switch_thread_to((void *)0x9f000, thread);
+}
+
+void init()
+{
+    initMemoryOperations();
+    enableGlobalPages();
+    enableLargePages();
+    initMemoryPool();
+    initZeroPagePools();
+    initSlabCaches();
+    initSharedSegments();
+    sysInitializeSysCall();
+    initTimers();
+    sysProgramManager.initialize();
+    tss.initialize();
+    sysMemoryManager.initialize();
+    sysFileSystem.init();
+    initSwap();
+    sysKeyboard.initialize();
+}
+
+// 在用户进程中运行基准测试process，由firstThread调用
+void runBenchmarkProcess(void *process)
+{
+    _enable_interrupt();
+    sysProgramManager.executeProcess(process, "", 1);
+    // 之后只是空转，降到最低优先级，否则优先级更高的本线程会一直占用处理器
+    sysProgramManager.setPriority(sysProgramManager.running(), MIN_PRIORITY);
+    while (1)
+    {
+    }
+}
+
+#endif
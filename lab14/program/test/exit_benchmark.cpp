@@ -0,0 +1,52 @@
+// fork+exit的吞吐量，子进程只有少量常驻页
+// 替换kernel.cpp后编译运行，每一行输出子进程常驻页数、每次fork+exit+wait的平均周期数
+
+#include "program/test/benchmark.h"
+
+void benchmarkProcess(void *arg)
+{
+    const dword residentPages[] = {0, 4, 16, 64};
+    const dword amount = sizeof(residentPages) / sizeof(dword);
+    const dword rounds = 32;
+
+    byte *buffer;
+    dword begin, cycles, pid;
+
+    printf("pages  fork+exit(cycles)\n");
+
+    for (dword i = 0; i < amount; ++i)
+    {
+        begin = sys_read_tsc();
+
+        for (dword j = 0; j < rounds; ++j)
+        {
+            pid = fork();
+            if (pid == 0)
+            {
+                // 子进程写residentPages[i]个新页后退出，退出时要释放这些页
+                if (residentPages[i])
+                {
+                    buffer = (byte *)malloc(residentPages[i] * PAGE_SIZE);
+                    for (dword k = 0; k < residentPages[i]; ++k)
+                    {
+                        buffer[k * PAGE_SIZE] = k;
+                    }
+                }
+                exit(0);
+            }
+            wait(nullptr);
+        }
+
+        cycles = (sys_read_tsc() - begin) / rounds;
+        printf("%d  %d\n", residentPages[i], cycles);
+    }
+
+    while (true)
+    {
+    }
+}
+
+void firstThread(void *arg)
+{
+    runBenchmarkProcess((void *)benchmarkProcess);
+}
@@ -0,0 +1,63 @@
+// fork延迟和进程常驻内存大小的关系
+// 替换kernel.cpp后编译运行，每一行输出常驻页数、fork返回父进程的周期数、
+// 子进程写完全部页(写时复制)的周期数
+
+#include "program/test/benchmark.h"
+
+void benchmarkProcess(void *arg)
+{
+    const dword residentPages[] = {0, 16, 64, 256, 1024};
+    const dword amount = sizeof(residentPages) / sizeof(dword);
+
+    byte *buffer;
+    dword begin, forkCycles, copyCycles, pid;
+
+    printf("pages  fork(cycles)  child write(cycles)\n");
+
+    for (dword i = 0; i < amount; ++i)
+    {
+        buffer = nullptr;
+        if (residentPages[i])
+        {
+            buffer = (byte *)malloc(residentPages[i] * PAGE_SIZE);
+            // 每页都写一次，保证页是常驻的
+            for (dword j = 0; j < residentPages[i]; ++j)
+            {
+                buffer[j * PAGE_SIZE] = j;
+            }
+        }
+
+        begin = sys_read_tsc();
+        pid = fork();
+
+        if (pid == 0)
+        {
+            begin = sys_read_tsc();
+            for (dword j = 0; j < residentPages[i]; ++j)
+            {
+                buffer[j * PAGE_SIZE] = 0;
+            }
+            copyCycles = sys_read_tsc() - begin;
+            printf("                      %d\n", copyCycles);
+            exit(0);
+        }
+
+        forkCycles = sys_read_tsc() - begin;
+        printf("%d  %d\n", residentPages[i], forkCycles);
+        wait(nullptr);
+
+        if (buffer)
+        {
+            free(buffer);
+        }
+    }
+
+    while (true)
+    {
+    }
+}
+
+void firstThread(void *arg)
+{
+    runBenchmarkProcess((void *)benchmarkProcess);
+}
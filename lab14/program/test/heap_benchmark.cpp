@@ -0,0 +1,112 @@
+// 用户堆的碎片率和吞吐量
+// 替换kernel.cpp后编译运行。随机地分配和释放不同大小的内存，输出每次操作的平均周期数、
+// 存活数据占实际使用物理内存的比例，以及realloc逐步增长时原地扩展的次数
+
+#include "program/test/benchmark.h"
+
+// 线性同余伪随机数
+dword seed = 1;
+dword random()
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) & 0x7fff;
+}
+
+// 70%为小对象，25%为中等对象，5%为大对象
+dword randomSize()
+{
+    dword kind = random() % 100;
+    if (kind < 70)
+        return 8 + random() % 248;
+    if (kind < 95)
+        return 256 + random() % 1792;
+    return 2048 + random() % 14336;
+}
+
+void benchmarkProcess(void *arg)
+{
+    const dword SLOTS = 256;
+    const dword OPERATIONS = 8192;
+
+    void *slots[SLOTS];
+    dword sizes[SLOTS];
+    dword liveBytes = 0, operations = 0;
+    dword usedBefore = userPool.length - userPool.freeCount;
+    dword cycles = 0, begin, index, usedPages;
+
+    seed = 1;
+    for (dword i = 0; i < SLOTS; ++i)
+    {
+        slots[i] = nullptr;
+        sizes[i] = 0;
+    }
+
+    for (dword i = 0; i < OPERATIONS; ++i)
+    {
+        index = random() % SLOTS;
+
+        if (slots[index])
+        {
+            begin = sys_read_tsc();
+            free(slots[index]);
+            cycles += sys_read_tsc() - begin;
+
+            liveBytes -= sizes[index];
+            slots[index] = nullptr;
+        }
+        else
+        {
+            sizes[index] = randomSize();
+
+            begin = sys_read_tsc();
+            slots[index] = malloc(sizes[index]);
+            cycles += sys_read_tsc() - begin;
+
+            if (!slots[index])
+                continue;
+
+            // 写第一个字节，让页真正被映射
+            *((byte *)slots[index]) = 1;
+            liveBytes += sizes[index];
+        }
+        ++operations;
+    }
+
+    usedPages = userPool.length - userPool.freeCount - usedBefore;
+    printf("malloc/free: %d ops, %d cycles/op\n", operations, cycles / operations);
+    printf("live bytes: %d, used pages: %d, utilization: %d percent\n",
+           liveBytes, usedPages, usedPages ? liveBytes * 100 / (usedPages * PAGE_SIZE) : 0);
+
+    // realloc逐步增长
+    byte *buffer = (byte *)malloc(64);
+    byte *moved;
+    dword inPlace = 0, steps = 64;
+
+    for (dword i = 1; i <= steps; ++i)
+    {
+        moved = (byte *)realloc(buffer, 64 + i * 512);
+        if (moved == buffer)
+            ++inPlace;
+        buffer = moved;
+    }
+    printf("realloc: %d of %d grew in place\n", inPlace, steps);
+
+    // calloc得到的内存必须全为0
+    dword *zeroed = (dword *)calloc(4096, sizeof(dword));
+    dword nonzero = 0;
+    for (dword i = 0; i < 4096; ++i)
+    {
+        if (zeroed[i])
+            ++nonzero;
+    }
+    printf("calloc: %d nonzero words\n", nonzero);
+
+    while (true)
+    {
+    }
+}
+
+void firstThread(void *arg)
+{
+    runBenchmarkProcess((void *)benchmarkProcess);
+}
@@ -0,0 +1,129 @@
+// 各种内存操作实现的吞吐量
+// 替换kernel.cpp后编译运行。对CPU支持的每一种实现，输出不同大小的memcpy、memset
+// 以及copyPage、clearPage每个周期处理的字节数，保留两位小数
+
+#include "program/test/benchmark.h"
+
+// 每种大小重复的次数
+#define BENCHMARK_REPEAT 16
+// 缓冲区的页数
+#define BENCHMARK_PAGES 32
+
+// 输出bytes/cycles，保留两位小数
+void printRate(dword bytes, dword cycles)
+{
+    dword rate = cycles ? bytes * 100 / cycles : 0;
+    printf("  %d.%d%d", rate / 100, (rate / 10) % 10, rate % 10);
+}
+
+// 逐字节复制，作为对照
+void copyBytes(const void *src, void *dst, dword count)
+{
+    const byte *srcPtr = (const byte *)src;
+    byte *dstPtr = (byte *)dst;
+
+    for (dword i = 0; i < count; ++i)
+    {
+        dstPtr[i] = srcPtr[i];
+    }
+}
+
+void benchmark(const MemoryOperations *operations, byte *src, byte *dst)
+{
+    const dword sizes[] = {64, 512, 4096, 65536};
+    const dword amount = sizeof(sizes) / sizeof(dword);
+    dword begin;
+
+    printf("%s\n  memcpy:", operations->name);
+    for (dword i = 0; i < amount; ++i)
+    {
+        begin = sys_read_tsc();
+        for (dword j = 0; j < BENCHMARK_REPEAT; ++j)
+        {
+            operations->copy(src, dst, sizes[i]);
+        }
+        printRate(sizes[i] * BENCHMARK_REPEAT, sys_read_tsc() - begin);
+    }
+
+    printf("\n  memset:");
+    for (dword i = 0; i < amount; ++i)
+    {
+        begin = sys_read_tsc();
+        for (dword j = 0; j < BENCHMARK_REPEAT; ++j)
+        {
+            operations->set(dst, 0x5a5a5a5a, sizes[i]);
+        }
+        printRate(sizes[i] * BENCHMARK_REPEAT, sys_read_tsc() - begin);
+    }
+
+    printf("\n  copyPage/clearPage:");
+    begin = sys_read_tsc();
+    for (dword i = 0; i < BENCHMARK_PAGES; ++i)
+    {
+        operations->copyPage(src + i * PAGE_SIZE, dst + i * PAGE_SIZE);
+    }
+    printRate(BENCHMARK_PAGES * PAGE_SIZE, sys_read_tsc() - begin);
+
+    begin = sys_read_tsc();
+    for (dword i = 0; i < BENCHMARK_PAGES; ++i)
+    {
+        operations->clearPage(dst + i * PAGE_SIZE);
+    }
+    printRate(BENCHMARK_PAGES * PAGE_SIZE, sys_read_tsc() - begin);
+    printf("\n");
+}
+
+void firstThread(void *arg)
+{
+    byte *src = (byte *)allocatePages(AddressPoolType::KERNEL, BENCHMARK_PAGES);
+    byte *dst = (byte *)allocatePages(AddressPoolType::KERNEL, BENCHMARK_PAGES);
+    dword begin;
+
+    for (dword i = 0; i < BENCHMARK_PAGES * PAGE_SIZE; ++i)
+    {
+        src[i] = i;
+    }
+
+    printf("bytes/cycle, memcpy and memset of 64, 512, 4096, 65536 bytes\n");
+    printf("cpuid edx: %x, using %s\n", cpuFeatures, memoryOperations->name);
+
+    printf("byte loop\n  memcpy:");
+    begin = sys_read_tsc();
+    copyBytes(src, dst, 65536);
+    printRate(65536, sys_read_tsc() - begin);
+    printf("\n");
+
+    for (dword i = 0; i < MEMORY_OPERATION_VARIANTS; ++i)
+    {
+        if (isMemoryOperationsSupported(memoryOperationVariants + i))
+        {
+            benchmark(memoryOperationVariants + i, src, dst);
+        }
+    }
+
+    // 检查复制和清零的结果
+    dword errors = 0;
+    memoryOperations->copyPage(src, dst);
+    memoryOperations->copy(src + 1, dst + PAGE_SIZE + 3, 1000);
+    for (dword i = 0; i < PAGE_SIZE; ++i)
+    {
+        if (dst[i] != src[i])
+            ++errors;
+    }
+    for (dword i = 0; i < 1000; ++i)
+    {
+        if (dst[PAGE_SIZE + 3 + i] != src[1 + i])
+            ++errors;
+    }
+    memoryOperations->clearPage(dst);
+    for (dword i = 0; i < PAGE_SIZE; ++i)
+    {
+        if (dst[i])
+            ++errors;
+    }
+    printf("check: %d errors\n", errors);
+
+    while (1)
+    {
+    }
+}
@@ -0,0 +1,55 @@
+// 就绪线程数和调度开销的关系
+// 替换kernel.cpp后编译运行。16~256个内核线程轮流调用schedule，
+// 每一行输出就绪线程数和每次切换的平均周期数，链表操作是O(1)时周期数不随线程数增长
+
+#include "program/test/benchmark.h"
+
+// 每种线程数下测量的轮数，每轮所有线程各切换一次
+#define SCHEDULE_ROUNDS 64
+// 线程数的上限
+#define MAX_THREADS 256
+
+// 累计的切换次数
+dword switches;
+
+void yieldThread(void *arg)
+{
+    while (true)
+    {
+        ++switches;
+        sysProgramManager.schedule();
+    }
+}
+
+void firstThread(void *arg)
+{
+    dword threads = 1, begin, cycles;
+
+    _enable_interrupt();
+    printf("threads  cycles/switch\n");
+
+    for (dword amount = 16; amount <= MAX_THREADS; amount *= 2)
+    {
+        // 加上本线程共amount个线程
+        for (; threads < amount; ++threads)
+        {
+            // 和本线程同一优先级，才会轮流执行
+            sysProgramManager.executeThread(yieldThread, nullptr, "yield", 2);
+        }
+
+        switches = 0;
+        begin = sys_read_tsc();
+        while (switches < SCHEDULE_ROUNDS * amount)
+        {
+            ++switches;
+            sysProgramManager.schedule();
+        }
+        cycles = (sys_read_tsc() - begin) / switches;
+
+        printf("%d  %d\n", amount, cycles);
+    }
+
+    while (1)
+    {
+    }
+}
@@ -0,0 +1,74 @@
+// 线程切换的开销
+// 替换kernel.cpp后编译运行。两个内核线程互相调用schedule切换，每次切换前访问一组内核页，
+// 分别输出保留cr3和每次都重新加载cr3(原来的做法)时每次切换的平均周期数
+
+#include "program/test/benchmark.h"
+
+// 每种情况的往返次数，每次往返切换两次
+#define SWITCH_ROUNDS 2000
+// 每次切换前访问的内核页数
+#define TOUCH_PAGES 32
+
+// 是否在切换前重新加载cr3
+bool reloadCr3;
+// 两个线程访问的内核页
+byte *touchBuffer;
+
+// 每页读一个字节，TLB项被清除后需要重新查页表
+dword touchPages()
+{
+    dword sum = 0;
+    for (dword i = 0; i < TOUCH_PAGES; ++i)
+    {
+        sum += touchBuffer[i * PAGE_SIZE];
+    }
+    return sum;
+}
+
+void switchOnce()
+{
+    touchPages();
+    if (reloadCr3)
+    {
+        sys_update_cr3(sysProgramManager.activePageDir);
+    }
+    sysProgramManager.schedule();
+}
+
+void partnerThread(void *arg)
+{
+    while (true)
+    {
+        switchOnce();
+    }
+}
+
+dword measure(bool reload)
+{
+    reloadCr3 = reload;
+
+    dword begin = sys_read_tsc();
+    for (dword i = 0; i < SWITCH_ROUNDS; ++i)
+    {
+        switchOnce();
+    }
+    return (sys_read_tsc() - begin) / (SWITCH_ROUNDS * 2);
+}
+
+void firstThread(void *arg)
+{
+    touchBuffer = (byte *)allocatePages(AddressPoolType::KERNEL, TOUCH_PAGES, true);
+    sysProgramManager.executeThread(partnerThread, nullptr, "partner", 2);
+    _enable_interrupt();
+
+    printf("global kernel pages: %s\n", (kernelPageFlags & PTE_GLOBAL) ? "yes" : "no");
+
+    // 先各切换一轮，两个线程的栈和PCB都进入cache
+    measure(false);
+    printf("keep cr3: %d cycles/switch\n", measure(false));
+    printf("reload cr3: %d cycles/switch\n", measure(true));
+
+    while (1)
+    {
+    }
+}
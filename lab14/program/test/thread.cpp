@@ -50,8 +50,8 @@ void Kernel()
 
 void init()
 {
-    // 32MB内存，bochs内置
-    initMemoryPool(0x2000000);
+    // 根据loader获取的内存布局初始化地址池
+    initMemoryPool();
 
     // 初始化系统调用表
     sysInitializeSysCall();
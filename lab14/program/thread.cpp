@@ -3,32 +3,50 @@
 #include "../clib/cstdlib.h"
 #include "tss.h"
 
-// 线程调度
+// 优先级超出范围时取最近的合法值
+static byte clampPriority(int priority)
+{
+    if (priority < MIN_PRIORITY)
+        return MIN_PRIORITY;
+    if (priority > MAX_PRIORITY)
+        return MAX_PRIORITY;
+    return priority;
+}
+
+// 线程调度，总是选择最高的非空就绪队列，同一队列中的线程轮转
 void ProgramManager::schedule()
 {
     _disable_interrupt();
 
-    // 只剩下一个线程/进程
-
-    if (readyPrograms.size() == 0)
-        return;
-
     if (currentRunning->status == ThreadStatus::RUNNING)
     {
+        // 只有用完了时间片才重新得到完整的时间片，被抢占的线程保留剩余的部分，
+        // 否则不断被抢占的线程永远用不完时间片，在多级反馈队列中也不会降级
+        if (!currentRunning->ticks)
+        {
+            currentRunning->ticks = timeSlice(currentRunning);
+        }
+
+        // 没有不低于当前线程的就绪线程，继续执行当前线程
+        if (!readyBitmap || highestReadyPriority() < readyLevel(currentRunning))
+        {
+            _enable_interrupt();
+            return;
+        }
+
         currentRunning->status = ThreadStatus::READY;
-        currentRunning->ticks = currentRunning->priority;
-        readyPrograms.push_back(&(currentRunning->tagInGeneralList));
+        pushReady(currentRunning);
     }
-    else
+    else if (!readyBitmap)
     {
+        // 只剩下一个线程/进程
+        return;
     }
 
-    ThreadListItem *item = readyPrograms.front();
-    PCB *next = threadListItem2PCB(item);
+    PCB *next = popReady();
     PCB *cur = currentRunning;
     next->status = ThreadStatus::RUNNING;
     currentRunning = next;
-    readyPrograms.pop_front();
 
     // printf("0x%x 0x%x\n", cur, next);
 
@@ -46,11 +64,42 @@ void ProgramManager::block()
     schedule();
 }
 
+// 睡眠定时器到期，在时钟中断中唤醒线程
+static void wakeSleeper(void *program)
+{
+    sysProgramManager.wakeUp((PCB *)program);
+}
+
+void ProgramManager::sleep(dword ticks)
+{
+    if (!ticks)
+        return;
+
+    bool status = _interrupt_status();
+    _disable_interrupt();
+
+    addTimer(&(currentRunning->sleepTimer), ticks, wakeSleeper, currentRunning);
+    block();
+
+    _set_interrupt(status);
+}
+
 // 唤醒线程
 void ProgramManager::wakeUp(PCB *program)
 {
     program->status = ThreadStatus::READY;
-    readyPrograms.push_front(&(program->tagInGeneralList));
+
+    // 多级反馈队列中，阻塞而让出处理器的线程升一级，并重新得到完整的时间片
+    if (policy == SchedulePolicy::MLFQ)
+    {
+        if (program->level)
+        {
+            --program->level;
+        }
+        program->ticks = timeSlice(program);
+    }
+
+    pushReady(program, true);
 }
 
 // 正在执行的线程/进程的pcb
@@ -59,6 +108,219 @@ PCB *ProgramManager::running()
     return currentRunning;
 }
 
+void ProgramManager::pushReady(PCB *program, bool front)
+{
+    dword index = readyLevel(program);
+    ThreadList &queue = readyQueues[index];
+
+    if (front)
+    {
+        queue.push_front(&(program->tagInGeneralList));
+    }
+    else
+    {
+        queue.push_back(&(program->tagInGeneralList));
+    }
+    readyBitmap |= 1u << index;
+}
+
+PCB *ProgramManager::popReady()
+{
+    if (!readyBitmap)
+        return nullptr;
+
+    dword index = highestReadyPriority();
+    ThreadList &queue = readyQueues[index];
+    PCB *program = threadListItem2PCB(queue.front());
+
+    queue.pop_front();
+    if (queue.empty())
+    {
+        readyBitmap &= ~(1u << index);
+    }
+
+    return program;
+}
+
+void ProgramManager::eraseReady(PCB *program)
+{
+    dword index = readyLevel(program);
+    ThreadList &queue = readyQueues[index];
+
+    queue.erase(&(program->tagInGeneralList));
+    if (queue.empty())
+    {
+        readyBitmap &= ~(1u << index);
+    }
+}
+
+void ProgramManager::setPriority(PCB *program, int priority)
+{
+    byte value = clampPriority(priority);
+
+    bool status = _interrupt_status();
+    _disable_interrupt();
+
+    if (program->status == ThreadStatus::READY)
+    {
+        // 移到新的就绪队列的队尾
+        eraseReady(program);
+        program->priority = value;
+        pushReady(program);
+    }
+    else
+    {
+        program->priority = value;
+    }
+
+    // 剩余的时间片不超过新的时间片
+    if (program->ticks > timeSlice(program))
+    {
+        program->ticks = timeSlice(program);
+    }
+
+    _set_interrupt(status);
+}
+
+void ProgramManager::setSchedulePolicy(SchedulePolicy policy)
+{
+    ThreadListItem *item;
+    PCB *program;
+
+    bool status = _interrupt_status();
+    _disable_interrupt();
+
+    // 就绪队列的下标和策略有关，先取出所有就绪线程，切换策略后再重新加入
+    for (item = allPrograms.front(); item; item = allPrograms.next(item))
+    {
+        program = threadListItem2PCB(item);
+        if (program->status == ThreadStatus::READY)
+        {
+            eraseReady(program);
+        }
+    }
+
+    this->policy = policy;
+    boostTicks = 0;
+
+    for (item = allPrograms.front(); item; item = allPrograms.next(item))
+    {
+        program = threadListItem2PCB(item);
+        program->level = 0;
+        program->ticks = timeSlice(program);
+        if (program->status == ThreadStatus::READY)
+        {
+            pushReady(program);
+        }
+    }
+
+    _set_interrupt(status);
+}
+
+bool ProgramManager::tick()
+{
+    PCB *cur = currentRunning;
+    bool expired = !cur->ticks;
+
+    if (policy == SchedulePolicy::MLFQ)
+    {
+        // 用完了整个时间片，降一级，在schedule中得到新级别的时间片
+        if (expired && cur->level + 1 < MLFQ_LEVELS)
+        {
+            ++cur->level;
+        }
+
+        if (++boostTicks >= MLFQ_BOOST_PERIOD)
+        {
+            boostTicks = 0;
+            boostAll();
+        }
+    }
+
+    // 时间片用完，或者有更高的就绪队列非空时抢占当前线程
+    return expired || (readyBitmap && highestReadyPriority() > readyLevel(cur));
+}
+
+void ProgramManager::boostAll()
+{
+    PCB *program;
+
+    for (ThreadListItem *item = allPrograms.front(); item; item = allPrograms.next(item))
+    {
+        program = threadListItem2PCB(item);
+        if (!program->level)
+            continue;
+
+        if (program->status == ThreadStatus::READY)
+        {
+            eraseReady(program);
+            program->level = 0;
+            pushReady(program);
+        }
+        else
+        {
+            program->level = 0;
+        }
+
+        // 级别变化后时间片也随之变化
+        program->ticks = timeSlice(program);
+    }
+}
+
+dword ProgramManager::scheduleInfo(ScheduleInfo *info, dword amount)
+{
+    dword count = 0;
+    PCB *program;
+    int i;
+
+    bool status = _interrupt_status();
+    _disable_interrupt();
+
+    for (ThreadListItem *item = allPrograms.front(); item && count < amount; item = allPrograms.next(item))
+    {
+        program = threadListItem2PCB(item);
+        ScheduleInfo &entry = info[count++];
+
+        entry.pid = program->pid;
+        for (i = 0; i < MAX_PROGRAM_NAME - 1 && program->name[i]; ++i)
+        {
+            entry.name[i] = program->name[i];
+        }
+        entry.name[i] = '\0';
+        entry.status = program->status;
+        entry.priority = program->priority;
+        entry.level = program->level;
+        entry.quantum = timeSlice(program);
+        entry.ticks = program->ticks;
+        entry.ticksPassedBy = program->ticksPassedBy;
+    }
+
+    _set_interrupt(status);
+    return count;
+}
+
+dword ProgramManager::highestReadyPriority()
+{
+    // 最高的非零位，bsr指令一次得到
+    return 31 - __builtin_clz(readyBitmap);
+}
+
+dword ProgramManager::readyLevel(PCB *program)
+{
+    if (policy == SchedulePolicy::MLFQ)
+        return MAX_PRIORITY - program->level;
+
+    return program->priority;
+}
+
+dword ProgramManager::timeSlice(PCB *program)
+{
+    if (policy == SchedulePolicy::MLFQ)
+        return MLFQ_BASE_QUANTUM << program->level;
+
+    return program->priority;
+}
+
 dword ProgramManager::executeThread(ThreadFunction func, void *arg, const char *name, byte priority)
 {
     PCB *thread = buildThreadPCB(func, arg, name, priority);
@@ -70,7 +332,7 @@ dword ProgramManager::executeThread(ThreadFunction func, void *arg, const char *
     bool interruptStatus = _interrupt_status();
     _disable_interrupt();
     allPrograms.push_back(&(thread->tagInAllList));
-    readyPrograms.push_back(&(thread->tagInGeneralList));
+    pushReady(thread);
     _set_interrupt(interruptStatus);
 
     return thread->pid;
@@ -82,34 +344,28 @@ dword ProgramManager::allocatePid()
     bool status = _interrupt_status();
     _disable_interrupt();
 
-    // 0号线程
-    if (allPrograms.empty())
-        return 0;
-
-    dword pid = -1;
-    PCB *program;
-
-    for (int i = 0; i < MAX_PROGRAM_AMOUNT; ++i)
-    {
-        program = findProgramByPid(i);
-        if (!program)
-        {
-            pid = i;
-            break;
-        }
-    }
+    // 按pid位图分配，不再逐个pid扫描所有线程
+    dword pid = pids.allocate(1);
 
     _set_interrupt(status);
 
     return pid;
 }
 
+void ProgramManager::releasePid(dword pid)
+{
+    bool status = _interrupt_status();
+    _disable_interrupt();
+    pids.release(pid, 1);
+    _set_interrupt(status);
+}
+
 PCB *ProgramManager::findProgramByPid(dword pid)
 {
     bool status = _interrupt_status();
     _disable_interrupt();
 
-    ThreadListItem *item = allPrograms.head.next;
+    ThreadListItem *item = allPrograms.front();
     PCB *program, *ans;
 
     ans = nullptr;
@@ -123,7 +379,7 @@ PCB *ProgramManager::findProgramByPid(dword pid)
             ans = program;
             break;
         }
-        item = item->next;
+        item = allPrograms.next(item);
     }
 
     _set_interrupt(status);
@@ -134,22 +390,24 @@ PCB *ProgramManager::findProgramByPid(dword pid)
 // 创建一个线程的PCB并返回
 PCB *ProgramManager::buildThreadPCB(ThreadFunction func, void *arg, const char *name, byte priority)
 {
-    PCB *thread = (PCB *)allocatePages(AddressPoolType::KERNEL, 1);
+    PCB *thread = (PCB *)allocatePages(AddressPoolType::KERNEL, 1, true);
     if (!thread)
         return nullptr;
 
-    memset((byte *)thread, 0, PAGE_SIZE);
-
     for (int i = 0; i < MAX_PROGRAM_NAME && name[i]; ++i)
     {
         (thread->name)[i] = name[i];
     }
 
     thread->status = ThreadStatus::READY;
-    thread->priority = priority;
-    thread->ticks = priority;
+    thread->priority = clampPriority(priority);
+    thread->level = 0;
+    thread->ticks = timeSlice(thread);
     thread->ticksPassedBy = 0;
     thread->pageDir = nullptr;
+    thread->parent = nullptr;
+    thread->children.initialize();
+    thread->childWaiters.initialize();
 
     /*
     // 初始化文件描述符数组
@@ -6,57 +6,90 @@
 #include "program_configure.h"
 #include "threadlist.h"
 #include "addresspool.h"
+#include "vma.h"
 #include "../ext2/directory_entry.h"
+#include "../kernel/timer.h"
 
 // 定义标识符ThreadFunction为函数指针void (*)(void *)类型
 typedef void (*ThreadFunction)(void *);
 
+// Arena的类型，小于MEM_BLOCK_TYPES时表示内存块大小类别的下标
 enum ArenaType
 {
-    ARENA_16,
-    ARENA_32,
-    ARENA_64,
-    ARENA_128,
-    ARENA_256,
-    ARENA_512,
-    ARENA_1024,
-    ARENA_MORE
+    ARENA_MORE = 0xff // 按页分配
 };
 
-struct Arena
+// 对于每个空闲的Arena内存块，利用其中的空间来存储链表中的节点的next指针
+
+struct MemoryBlockListItem
 {
-    ArenaType type; // Arena的类型
-    dword counter;  // 如果是ARENA_MORE则counter表明页框数，否则counter表明内存块的数量
+    MemoryBlockListItem *next;
 };
 
-// 对于每个空闲的Arena内存块，利用其中的空间来存储链表中的节点的previus和next指针
+struct Arena
+{
+    ArenaType type;                  // Arena的类型
+    dword counter;                   // 如果是ARENA_MORE则counter表明页框数，否则counter表明空闲内存块的数量
+    MemoryBlockListItem *freeBlocks; // Arena内的空闲内存块
+    Arena *previous, *next;          // 在partial/full/empty链表中的位置
+};
 
-struct MemoryBlockListItem
+// 一种大小的内存块的统计信息
+struct ArenaStats
 {
-    MemoryBlockListItem *previous, *next;
+    dword size;   // 内存块大小
+    dword blocks; // 已分配的内存块数
+    dword arenas; // 占用的Arena数
 };
 
-// MemoryManager是在内核态调用的内存管理对象
+// MemoryManager是在内核态调用的内存管理对象，链表操作和页的分配都在关中断下进行，
+// 不会在时钟中断切换线程时被打断
 
 class MemoryManager
 {
 
+public:
+    // 16, 20, 24, 28, 32, 40, ..., 1280, 1536, 1792，每个2的幂之间分4级
+    static const dword MEM_BLOCK_TYPES = 28;      // 内存块的类型数目
+    dword failures;                               // 分配失败的次数
+
 private:
-    // 16, 32, 64, 128, 256, 512, 1024
-    static const dword MEM_BLOCK_TYPES = 7;       // 内存块的类型数目
-    static const dword minSize = 16;              // 内存块的最小大小
-    dword arenaSize[MEM_BLOCK_TYPES];             // 每种类型对应的内存块大小
-    MemoryBlockListItem *arenas[MEM_BLOCK_TYPES]; // 每种类型的arena内存块的指针
-    Semaphore mutex;
+    static const dword MAX_EMPTY_ARENAS = 4;      // 最多缓存的空Arena数
+    // 能分配的最大字节数，再大时加上Arena并上取整到页会溢出
+    static const dword MAX_ALLOCATE_SIZE = 0xffffffff - sizeof(Arena) - PAGE_SIZE;
+    static const dword arenaSize[MEM_BLOCK_TYPES]; // 每种类型对应的内存块大小
+    Arena *partialArenas[MEM_BLOCK_TYPES];        // 还有空闲内存块的Arena
+    Arena *fullArenas[MEM_BLOCK_TYPES];           // 内存块全部分配出去的Arena
+    Arena *emptyArenas;                           // 内存块全部空闲的Arena，不区分类型
+    dword emptyArenaCount;                        // 空Arena的数量
+    AddressPoolType type;                         // Arena从哪个地址池分配
 
 public:
     MemoryManager();
-    void initialize();
+    // 初始化，type=Arena所在的地址池，内核堆为KERNEL，进程的堆为USER
+    void initialize(const AddressPoolType type = AddressPoolType::KERNEL);
     void *allocate(dword size);  // 分配一块地址
     void release(void *address); // 释放一块地址
+    // 调整内存块的大小，能原地扩展时不移动数据
+    void *reallocate(void *address, dword size);
+    // 分配一块清零的地址
+    void *allocateZeroed(dword size);
+    // 统计每种大小的内存块，stats有MEM_BLOCK_TYPES项，返回缓存的空Arena数
+    dword statistics(ArenaStats *stats);
 
 private:
-    bool getNewArena(AddressPoolType type, dword index);
+    // 能容纳size字节的最小内存块类型，若没有则返回MEM_BLOCK_TYPES
+    dword sizeClass(dword size);
+    // index类型的Arena中的内存块数量
+    dword arenaBlocks(dword index);
+    // 为index类型分配一个新的Arena
+    bool getNewArena(dword index);
+    // 将Arena划分成index类型的内存块
+    void formatArena(Arena *arena, dword index);
+    // 从链表中删除Arena
+    void unlinkArena(Arena **list, Arena *arena);
+    // 将Arena放到链表的头部
+    void linkArena(Arena **list, Arena *arena);
 };
 
 // 线程的状态
@@ -109,6 +142,7 @@ struct PCB
     char name[MAX_PROGRAM_NAME];     // 线程名
     enum ThreadStatus status;        // 线程的状态
     byte priority;                   // 线程优先级
+    byte level;                      // 在多级反馈队列中的级别
     dword pid;                       // 线程pid
     dword ticks;                     // 线程时间片总时间
     dword ticksPassedBy;             // 线程已执行时间
@@ -116,15 +150,37 @@ struct PCB
     ThreadListItem tagInAllList;     // 线程队列标识
 
     dword *pageDir;              // 页目录表地址，虚拟地址，位于内核空间
-    AddressPool userVaddr;       // 进程用户地址池
+    VirtualAreaList userVaddr;   // 进程用户地址空间的区域表
     MemoryManager memoryManager; // 进程内存管理者
     dword parentPid;             // 父进程pid
+    PCB *parent;                 // 父进程，孤儿进程由init进程收养
+    ThreadList children;         // 子进程链表
+    ThreadListItem tagInChildList; // 在父进程子进程链表中的标识
+    ThreadList childWaiters;     // 在wait中等待子进程退出的线程
+    Timer sleepTimer;            // 睡眠到期时唤醒线程的定时器
     dword returnStatus;          // 返回状态保存
 
     dword fileDescriptors[MAX_FILE_OPEN_PER_PROCESS]; // 保存的是文件表中的下标
     DirectoryEntry currentDirectory;
 };
 
+// 线程的调度信息，供ps命令查看
+struct ScheduleInfo
+{
+    dword pid;
+    char name[MAX_PROGRAM_NAME];
+    ThreadStatus status;
+    byte priority;
+    byte level;          // 在多级反馈队列中的级别
+    dword quantum;       // 当前调度策略下的时间片
+    dword ticks;         // 剩余的时间片
+    dword ticksPassedBy; // 已执行的时钟中断数
+};
+
 MemoryManager sysMemoryManager;
 
+// 内核代码直接使用的内核堆，不经过系统调用，在进程中调用也从内核堆分配
+void *kmalloc(dword size);
+void kfree(void *address);
+
 #endif
\ No newline at end of file
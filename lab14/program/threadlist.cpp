@@ -2,170 +2,105 @@
 ThreadList::ThreadList()
 {
     //printf("In thread list constructor\n");
-    head.next = head.previous = 0;
+    initialize();
 }
 
 void ThreadList::initialize()
 {
-    head.next = head.previous = 0;
+    head.next = head.previous = &head;
+    count = 0;
 }
 
 int ThreadList::size()
 {
-    ThreadListItem *temp = head.next;
-    int counter = 0;
-
-    while (temp)
-    {
-        temp = temp->next;
-        ++counter;
-    }
-
-    return counter;
+    return count;
 }
 
 bool ThreadList::empty()
 {
-    return size() == 0;
+    return count == 0;
 }
 
 ThreadListItem *ThreadList::back()
 {
-    ThreadListItem *temp = head.next;
-    if (!temp)
-        return nullptr;
-
-    while (temp->next)
-    {
-        temp = temp->next;
-    }
-
-    return temp;
+    return count ? head.previous : nullptr;
 }
 
 void ThreadList::push_back(ThreadListItem *itemPtr)
 {
-    ThreadListItem *temp = back();
-    if (temp == nullptr)
-        temp = &head;
-    temp->next = itemPtr;
-    itemPtr->previous = temp;
-    itemPtr->next = nullptr;
+    link(&head, itemPtr);
 }
 
 void ThreadList::pop_back()
 {
-    ThreadListItem *temp = back();
-    if (temp)
+    if (count)
     {
-        temp->previous->next = nullptr;
-        temp->previous = temp->next = nullptr;
+        erase(head.previous);
     }
 }
 
 ThreadListItem *ThreadList::front()
 {
-    return head.next;
+    return count ? head.next : nullptr;
+}
+
+ThreadListItem *ThreadList::next(ThreadListItem *itemPtr)
+{
+    return itemPtr->next == &head ? nullptr : itemPtr->next;
 }
 
 void ThreadList::push_front(ThreadListItem *itemPtr)
 {
-    ThreadListItem *temp = head.next;
-    if (temp)
-    {
-        temp->previous = itemPtr;
-    }
-    head.next = itemPtr;
-    itemPtr->previous = &head;
-    itemPtr->next = temp;
+    link(head.next, itemPtr);
 }
 
 void ThreadList::pop_front()
 {
-    ThreadListItem *temp = head.next;
-    if (temp)
+    if (count)
     {
-        if (temp->next)
-        {
-            temp->next->previous = &head;
-        }
-        head.next = temp->next;
-        temp->previous = temp->next = nullptr;
+        erase(head.next);
     }
 }
 
 void ThreadList::insert(int pos, ThreadListItem *itemPtr)
 {
-    if (pos == 0)
+    if (pos == count)
     {
-        push_front(itemPtr);
+        push_back(itemPtr);
     }
-    else
+    else if (pos >= 0 && pos < count)
     {
-        int length = size();
-        if (pos == length)
-        {
-            push_back(itemPtr);
-        }
-        else if (pos < length)
-        {
-            ThreadListItem *temp = at(pos);
-
-            itemPtr->previous = temp->previous;
-            itemPtr->next = temp;
-            temp->previous->next = itemPtr;
-            temp->previous = itemPtr;
-        }
+        link(at(pos), itemPtr);
     }
 }
 
 void ThreadList::erase(int pos)
 {
-    if (pos == 0)
-    {
-        pop_front();
-    }
-    else
+    ThreadListItem *temp = at(pos);
+    if (temp)
     {
-        int length = size();
-        if (pos < length)
-        {
-            ThreadListItem *temp = at(pos);
-
-            temp->previous->next = temp->next;
-            if (temp->next)
-            {
-                temp->next->previous = temp->previous;
-            }
-        }
+        erase(temp);
     }
 }
 
 void ThreadList::erase(ThreadListItem *itemPtr)
 {
-    ThreadListItem *temp = head.next;
-    
-    while (temp && temp != itemPtr)
-    {
-        temp = temp->next;
-    }
-
-
-    if (temp)
-    {
-        temp->previous->next = temp->next;
-        if (temp->next)
-        {
-            temp->next->previous = temp->previous;
-        }
-    }
+    // 元素自身记录了前后元素，不需要查找
+    itemPtr->previous->next = itemPtr->next;
+    itemPtr->next->previous = itemPtr->previous;
+    itemPtr->previous = itemPtr->next = nullptr;
+    --count;
 }
+
 ThreadListItem *ThreadList::at(int pos)
 {
-    ThreadListItem *temp = head.next;
+    if (pos < 0 || pos >= count)
+        return nullptr;
 
-    for (int i = 0; (i < pos) && temp; ++i, temp = temp->next)
+    ThreadListItem *temp = head.next;
+    for (int i = 0; i < pos; ++i)
     {
+        temp = temp->next;
     }
 
     return temp;
@@ -174,19 +109,20 @@ ThreadListItem *ThreadList::at(int pos)
 int ThreadList::find(ThreadListItem *itemPtr)
 {
     int pos = 0;
-    ThreadListItem *temp = head.next;
-    while (temp && temp != itemPtr)
+    for (ThreadListItem *temp = head.next; temp != &head; temp = temp->next, ++pos)
     {
-        temp = temp->next;
-        ++pos;
+        if (temp == itemPtr)
+            return pos;
     }
 
-    if (temp && temp == itemPtr)
-    {
-        return pos;
-    }
-    else
-    {
-        return -1;
-    }
-}
\ No newline at end of file
+    return -1;
+}
+
+void ThreadList::link(ThreadListItem *position, ThreadListItem *itemPtr)
+{
+    itemPtr->previous = position->previous;
+    itemPtr->next = position;
+    position->previous->next = itemPtr;
+    position->previous = itemPtr;
+    ++count;
+}
@@ -7,10 +7,13 @@ struct ThreadListItem
     ThreadListItem *next;
 };
 
+// 带哨兵的循环双向链表，head.next是第一个元素，head.previous是最后一个元素，
+// 空链表的哨兵指向自己，头尾的插入删除和按元素删除都是O(1)的
 class ThreadList
 {
 public:
     ThreadListItem head;
+    int count; // 元素个数
 
 public:
     // 初始化ThreadList
@@ -31,6 +34,8 @@ public:
     // 返回指向ThreadList第一个元素的指针
     // 若没有，则返回nullptr
     ThreadListItem *front();
+    // 返回itemPtr的下一个元素，itemPtr是最后一个元素时返回nullptr
+    ThreadListItem *next(ThreadListItem *itemPtr);
     // 将一个元素加入到ThreadList的头部
     void push_front(ThreadListItem *itemPtr);
     // 删除ThreadList第一个元素
@@ -39,11 +44,16 @@ public:
     void insert(int pos, ThreadListItem *itemPtr);
     // 删除pos位置处的元素
     void erase(int pos);
+    // 删除元素itemPtr，itemPtr必须在ThreadList中
     void erase(ThreadListItem *itemPtr);
     // 返回指向pos位置处的元素的指针
     ThreadListItem *at(int pos);
     // 返回给定元素在ThreadList中的序号
     int find(ThreadListItem *itemPtr);
+
+private:
+    // 将itemPtr插入到position之前
+    void link(ThreadListItem *position, ThreadListItem *itemPtr);
 };
 
-#endif
\ No newline at end of file
+#endif
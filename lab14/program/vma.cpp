@@ -0,0 +1,204 @@
+#include "vma.h"
+
+VirtualAreaList::VirtualAreaList()
+{
+    areas = nullptr;
+    count = 0;
+    capacity = 0;
+    startAddress = 0;
+    endAddress = 0;
+}
+
+void VirtualAreaList::initialize(VirtualArea *areas, const dword capacity, const dword startAddress, const dword endAddress)
+{
+    this->areas = areas;
+    this->count = 0;
+    this->capacity = capacity;
+    this->startAddress = startAddress;
+    this->endAddress = endAddress;
+}
+
+dword VirtualAreaList::allocate(const dword amount, const dword flags, const dword file, const dword offset)
+{
+    if (amount == 0)
+        return -1;
+
+    dword size = amount * PAGE_SIZE;
+    dword previous = startAddress;
+    dword next;
+
+    // 首次适应，依次检查各区域之间的空隙
+    for (dword i = 0; i <= count; ++i)
+    {
+        next = (i < count) ? areas[i].start : endAddress;
+
+        if (next - previous >= size)
+        {
+            VirtualArea area = {previous, previous + size, flags, file, offset};
+            return add(i, area) ? previous : -1;
+        }
+
+        if (i < count)
+        {
+            previous = areas[i].end;
+        }
+    }
+
+    return -1;
+}
+
+bool VirtualAreaList::allocateAt(const dword address, const dword amount, const dword flags,
+                                 const dword file, const dword offset)
+{
+    dword end = address + amount * PAGE_SIZE;
+
+    if (amount == 0 || address < startAddress || end > endAddress || end < address)
+        return false;
+
+    // 第一个可能和[address, end)重叠的区域
+    dword i = lowerBound(address);
+    if (i < count && areas[i].start < end)
+        return false;
+
+    VirtualArea area = {address, end, flags, file, offset};
+    return add(i, area);
+}
+
+bool VirtualAreaList::release(const dword address, const dword amount)
+{
+    dword end = address + amount * PAGE_SIZE;
+    dword i = lowerBound(address);
+
+    while (i < count && areas[i].start < end)
+    {
+        if (areas[i].start < address && areas[i].end > end)
+        {
+            // 从区域中间挖去一段，拆成两个区域
+            VirtualArea rest = areas[i];
+            rest.offset += end - areas[i].start;
+            rest.start = end;
+            if (!insert(i + 1, rest))
+                return false;
+            areas[i].end = address;
+            return true;
+        }
+
+        if (areas[i].start < address)
+        {
+            areas[i].end = address;
+            ++i;
+        }
+        else if (areas[i].end > end)
+        {
+            areas[i].offset += end - areas[i].start;
+            areas[i].start = end;
+            ++i;
+        }
+        else
+        {
+            erase(i);
+        }
+    }
+
+    return true;
+}
+
+VirtualArea *VirtualAreaList::find(const dword address)
+{
+    dword i = lowerBound(address);
+
+    if (i < count && areas[i].start <= address)
+        return areas + i;
+
+    return nullptr;
+}
+
+void VirtualAreaList::copy(const VirtualAreaList &other)
+{
+    count = other.count;
+    startAddress = other.startAddress;
+    endAddress = other.endAddress;
+
+    for (dword i = 0; i < count; ++i)
+    {
+        areas[i] = other.areas[i];
+    }
+}
+
+dword VirtualAreaList::lowerBound(const dword address)
+{
+    // 二分查找
+    dword low = 0, high = count, mid;
+
+    while (low < high)
+    {
+        mid = (low + high) / 2;
+        if (areas[mid].end <= address)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+bool VirtualAreaList::add(const dword index, const VirtualArea &area)
+{
+    // 紧接在前一个区域之后，直接扩展前一个区域
+    if (index > 0 && canMerge(areas[index - 1], area))
+    {
+        areas[index - 1].end = area.end;
+
+        // 空隙被填满，和后一个区域连成一片
+        if (index < count && canMerge(areas[index - 1], areas[index]))
+        {
+            areas[index - 1].end = areas[index].end;
+            erase(index);
+        }
+        return true;
+    }
+
+    // 紧挨着后一个区域，直接扩展后一个区域
+    if (index < count && canMerge(area, areas[index]))
+    {
+        areas[index].start = area.start;
+        return true;
+    }
+
+    return insert(index, area);
+}
+
+bool VirtualAreaList::insert(const dword index, const VirtualArea &area)
+{
+    if (count == capacity)
+        return false;
+
+    for (dword i = count; i > index; --i)
+    {
+        areas[i] = areas[i - 1];
+    }
+
+    areas[index] = area;
+    ++count;
+
+    return true;
+}
+
+bool VirtualAreaList::canMerge(const VirtualArea &a, const VirtualArea &b)
+{
+    // 文件映射区域各自对应文件的一段，共享内存区域各自对应一个段，不合并
+    return a.end == b.start && a.flags == b.flags && !(a.flags & (VMA_FILE | VMA_SHARED));
+}
+
+void VirtualAreaList::erase(const dword index)
+{
+    for (dword i = index; i + 1 < count; ++i)
+    {
+        areas[i] = areas[i + 1];
+    }
+    --count;
+}
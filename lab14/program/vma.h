@@ -0,0 +1,68 @@
+#ifndef VMA_H
+#define VMA_H
+
+#include "../configure/type.h"
+#include "../configure/os_configure.h"
+
+// 虚拟内存区域的属性
+#define VMA_READ 0x1
+#define VMA_WRITE 0x2
+// 匿名区域，首次访问时映射清零的物理页
+#define VMA_ANONYMOUS 0x4
+// 文件映射区域，首次访问时从文件读入，脏页写回文件
+#define VMA_FILE 0x8
+// 共享内存区域，映射共享内存段的全部页，fork后父子进程仍共享
+#define VMA_SHARED 0x10
+
+// 一段连续的、属性相同的用户虚拟地址[start, end)
+struct VirtualArea
+{
+    dword start;
+    dword end;
+    dword flags;
+    dword file;   // 文件映射区域的文件句柄，共享内存区域的段号
+    dword offset; // start对应的文件偏移
+};
+
+// 进程的虚拟内存区域表，各区域按起始地址有序排列且互不重叠，
+// 相邻且属性相同的匿名区域会被合并
+class VirtualAreaList
+{
+public:
+    VirtualArea *areas;  // 区域数组
+    dword count;         // 区域个数
+    dword capacity;      // 区域数组的容量
+    dword startAddress;  // 可分配的最低地址
+    dword endAddress;    // 可分配的最高地址(不含)
+
+public:
+    VirtualAreaList();
+    // 设置区域数组，areas=数组起始地址，capacity=容量，[startAddress, endAddress)为可分配的地址范围
+    void initialize(VirtualArea *areas, const dword capacity, const dword startAddress, const dword endAddress);
+    // 分配amount个连续的页，返回起始地址，若没有则返回-1，文件映射区域还要给出文件句柄和文件偏移
+    dword allocate(const dword amount, const dword flags = VMA_READ | VMA_WRITE | VMA_ANONYMOUS,
+                   const dword file = -1, const dword offset = 0);
+    // 分配从address开始的amount个页，若其中有页已被分配则返回false
+    bool allocateAt(const dword address, const dword amount, const dword flags = VMA_READ | VMA_WRITE | VMA_ANONYMOUS,
+                    const dword file = -1, const dword offset = 0);
+    // 释放从address开始的amount个页，可以只释放区域的一部分
+    bool release(const dword address, const dword amount);
+    // 返回包含address的区域，若没有则返回nullptr
+    VirtualArea *find(const dword address);
+    // 复制另一个进程的区域表
+    void copy(const VirtualAreaList &other);
+
+private:
+    // 第一个end大于address的区域的下标
+    dword lowerBound(const dword address);
+    // 在下标index处加入区域area，与相邻且属性相同的匿名区域合并
+    bool add(const dword index, const VirtualArea &area);
+    // 在下标index处插入区域area
+    bool insert(const dword index, const VirtualArea &area);
+    // 区域a之后能否紧接着合并区域b
+    bool canMerge(const VirtualArea &a, const VirtualArea &b);
+    // 删除下标index处的区域
+    void erase(const dword index);
+};
+
+#endif
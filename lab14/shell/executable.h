@@ -3,6 +3,7 @@
 
 #include "../kernel/type.h"
 #include "../kernel/syscall.h"
+#include "../kernel/timer.h"
 
 #define SHELL_EXE_MULTIPROCESS "multiprocess"
 
@@ -18,11 +19,8 @@ namespace executable
     }
     void delay()
     {
-        dword temp = 0x7ffff;
-        while (temp)
-        {
-            --temp;
-        }
+        // 睡眠一次时钟中断，不再空转
+        sleep(MS_PER_TICK);
     }
 
     void multiprocess_1(void *arg)
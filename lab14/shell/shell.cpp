@@ -111,6 +111,23 @@ void Shell::run()
         } else if(strlib::strcmp((char *)cmd, SHELL_CLEAR) == 0) {
             clear();
         }
+        else if (strlib::strcmp((char *)cmd, SHELL_FREE) == 0)
+        {
+            printFree();
+        }
+        else if (strlib::strcmp((char *)cmd, SHELL_VMSTAT) == 0)
+        {
+            printVmstat();
+        }
+        else if (strlib::strcmp((char *)cmd, SHELL_PS) == 0)
+        {
+            printPrograms();
+        }
+        else if (strlib::strcmp((char *)cmd, SHELL_SCHED) == 0)
+        {
+            extractNextParameter();
+            sched((char *)parameter);
+        }
         else
         {
             printf("command \"%s\" is not supported\n", cmd);
@@ -152,9 +169,8 @@ void Shell::inputAndShow()
 
     while (1)
     {
-        while (!sysKeyboard.pop(&code))
-        {
-        }
+        // 没有输入时阻塞，不再空转
+        code = sysKeyboard.read();
 
         if (code & 0x80)
         {
@@ -625,4 +641,84 @@ void Shell::exec(const char *program)
     {
         printf("\"%s\" is not found\n", program);
     }
-}
\ No newline at end of file
+}
+
+void Shell::printFree()
+{
+    MemoryStats stats;
+    memoryStats(&stats);
+
+    // 单位为页
+    printf("pages        total   used   free   largest free\n");
+    printf("kernel       %d   %d   %d   %d\n", stats.kernelPool.total,
+           stats.kernelPool.total - stats.kernelPool.free, stats.kernelPool.free, stats.kernelPool.largestFree);
+    printf("user         %d   %d   %d   %d\n", stats.userPool.total,
+           stats.userPool.total - stats.userPool.free, stats.userPool.free, stats.userPool.largestFree);
+    printf("kernel vaddr %d   %d   %d   %d\n", stats.kernelVirtualPool.total,
+           stats.kernelVirtualPool.total - stats.kernelVirtualPool.free,
+           stats.kernelVirtualPool.free, stats.kernelVirtualPool.largestFree);
+    printf("swap         %d   %d   %d\n", stats.swapPages, stats.swapUsed, stats.swapPages - stats.swapUsed);
+    printf("zeroed pages: %d\n", stats.zeroPages);
+}
+
+void Shell::printVmstat()
+{
+    MemoryStats stats;
+    memoryStats(&stats);
+
+    printf("page faults: %d, copy on write: %d\n", stats.counters.pageFaults, stats.counters.copyOnWrites);
+    printf("forks: %d, page tables copied: %d\n", stats.counters.forks, stats.counters.forkPageTables);
+    printf("swap in: %d, swap out: %d\n", stats.counters.swapIns, stats.counters.swapOuts);
+    printf("page allocation failures: %d\n", stats.counters.pageFailures);
+
+    printArenas("kernel heap", stats.kernelArenas, stats.kernelEmptyArenas, stats.kernelHeapFailures);
+    printArenas("user heap", stats.userArenas, stats.userEmptyArenas, stats.userHeapFailures);
+}
+
+void Shell::printArenas(const char *name, const ArenaStats *arenas, dword emptyArenas, dword failures)
+{
+    printf("%s: %d empty arenas, %d failures\n", name, emptyArenas, failures);
+    printf("  size   blocks   arenas\n");
+
+    // 只打印占用了Arena的类型
+    for (dword i = 0; i < MemoryManager::MEM_BLOCK_TYPES; ++i)
+    {
+        if (arenas[i].arenas)
+        {
+            printf("  %d   %d   %d\n", arenas[i].size, arenas[i].blocks, arenas[i].arenas);
+        }
+    }
+}
+
+void Shell::printPrograms()
+{
+    const char *states[] = {"running", "ready", "blocked", "dead"};
+    ScheduleInfo info[SHELL_PS_AMOUNT];
+    dword amount = scheduleInfo(info, SHELL_PS_AMOUNT);
+
+    printf("pid  name  state  priority  level  quantum  ticks  total ticks\n");
+    for (dword i = 0; i < amount; ++i)
+    {
+        printf("%d  %s  %s  %d  %d  %d  %d  %d\n", info[i].pid, info[i].name, states[info[i].status],
+               info[i].priority, info[i].level, info[i].quantum, info[i].ticks, info[i].ticksPassedBy);
+    }
+}
+
+void Shell::sched(const char *policy)
+{
+    if (strlib::strcmp(policy, SHELL_SCHED_RR) == 0)
+    {
+        schedulePolicy(SchedulePolicy::ROUND_ROBIN);
+    }
+    else if (strlib::strcmp(policy, SHELL_SCHED_MLFQ) == 0)
+    {
+        schedulePolicy(SchedulePolicy::MLFQ);
+    }
+    else if (policy[0])
+    {
+        printf("policy \"%s\" is not supported\n", policy);
+        return;
+    }
+
+    printf("schedule policy: %s\n", sysProgramManager.policy == SchedulePolicy::MLFQ ? SHELL_SCHED_MLFQ : SHELL_SCHED_RR);
+}
@@ -20,6 +20,15 @@
 #define SHELL_TOUCH "touch"
 #define SHELL_PWD "pwd"
 #define SHELL_CLEAR "clear"
+#define SHELL_FREE "free"
+#define SHELL_VMSTAT "vmstat"
+#define SHELL_PS "ps"
+#define SHELL_SCHED "sched"
+
+#define SHELL_SCHED_RR "rr"
+#define SHELL_SCHED_MLFQ "mlfq"
+// ps最多列出的线程数
+#define SHELL_PS_AMOUNT 32
 
 #define SHELL_RM_FILE "-f"
 #define SHELL_RM_DIR "-d"
@@ -68,6 +77,16 @@ private:
     void cat(const char *path);
     // exec
     void exec(const char *program);
+    // free，打印各地址池的使用情况
+    void printFree();
+    // vmstat，打印内存事件的计数和堆的使用情况
+    void printVmstat();
+    // 打印一个堆中已使用的内存块类型
+    void printArenas(const char *name, const ArenaStats *arenas, dword emptyArenas, dword failures);
+    // ps，打印各线程的优先级、队列级别和时间片
+    void printPrograms();
+    // sched，切换调度策略
+    void sched(const char *policy);
 };
 
 #endif
\ No newline at end of file